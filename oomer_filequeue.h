@@ -1,6 +1,18 @@
 #pragma once
 #include <string>       // For std::string
 #include <iostream>
+#include <mutex>        // For std::mutex
+#include <condition_variable> // For WakeSignal
+#include <chrono>       // For debounce quiet periods
+#include <unordered_map> // For DebounceStage
+#include <vector>
+#include <algorithm>    // For std::sort
+#include <deque>        // For the FileQueue FIFO
+#include <tuple>
+#include <map>
+#include <set>          // For PriorityFileQueue
+#include <atomic>       // For PathHandoffQueue
+#include <filesystem>   // For events inside a .vmax that was deleted
 
 #include <efsw/FileSystem.hpp> // For file watching
 #include <efsw/System.hpp> // For file watching
@@ -32,8 +44,118 @@ efsw::WatchID handleWatchID( efsw::WatchID watchid ) {
 	return watchid;
 }
 
+/// Wakes the main loop when there is something to do, instead of polling
+/// notify() before anyone waits is not lost, the next wait() returns right away
+class WakeSignal {
+    public:
+        void notify() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending = true;
+            }
+            condition.notify_one();
+        }
+
+        // Block until notify() was called, uses no cpu while waiting
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return pending; });
+            pending = false;
+        }
+
+        // Same as wait() but gives up after timeout
+        void waitFor(std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait_for(lock, timeout, [this] { return pending; });
+            pending = false;
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool pending = false;
+    };
+
+/// Holds file events until a path has been quiet for a while
+/// efsw reports several Modified events while a big file is still being written,
+/// only the last one matters and it is released once writes have stopped
+class DebounceStage {
+    public:
+        enum class Event { Added, Modified, Deleted };
+
+        explicit DebounceStage(std::chrono::milliseconds quiet = std::chrono::milliseconds(500))
+            : quietPeriod(quiet) {}
+
+        void setQuietPeriod(std::chrono::milliseconds quiet) {
+            std::lock_guard<std::mutex> lock(mutex);
+            quietPeriod = quiet;
+        }
+
+        // Record an event, the latest event per path wins
+        // Adds and modifies are held, a delete drops whatever is held for the path
+        // @return true when a delete has to be passed on now, false when it cancelled
+        //         a held Add (the file came and went before anyone saw it) or for adds and modifies
+        bool record(const std::string& path, Event event) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = pending.find(path);
+            if (event == Event::Deleted) {
+                if (found == pending.end()) return true;
+                bool added = found->second.added;
+                pending.erase(found);
+                return !added;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (found == pending.end()) {
+                pending[path] = Pending{now, now, event == Event::Added};
+            } else {
+                found->second.lastEvent = now;
+            }
+            return false;
+        }
+
+        // Take the paths that have been quiet for the full period, oldest first
+        // @param nextDue: time until the next held path is due, milliseconds::max() when nothing is held
+        // @param firstEvents: optional, gets the time of the first event of each returned path
+        std::vector<std::string> takeQuiet(std::chrono::milliseconds& nextDue,
+                                           std::vector<std::chrono::steady_clock::time_point>* firstEvents = nullptr) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto now = std::chrono::steady_clock::now();
+            std::vector<std::tuple<std::chrono::steady_clock::time_point, std::string, std::chrono::steady_clock::time_point>> ready;
+            nextDue = std::chrono::milliseconds::max();
+            for (auto it = pending.begin(); it != pending.end();) {
+                auto quietFor = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second.lastEvent);
+                if (quietFor >= quietPeriod) {
+                    ready.emplace_back(it->second.lastEvent, it->first, it->second.firstEvent);
+                    it = pending.erase(it);
+                } else {
+                    nextDue = std::min(nextDue, quietPeriod - quietFor);
+                    ++it;
+                }
+            }
+            std::sort(ready.begin(), ready.end());
+            std::vector<std::string> paths;
+            for (auto& [time, path, firstEvent] : ready) {
+                paths.push_back(std::move(path));
+                if (firstEvents) firstEvents->push_back(firstEvent);
+            }
+            return paths;
+        }
+
+    private:
+        struct Pending {
+            std::chrono::steady_clock::time_point firstEvent; // for queue latency stats
+            std::chrono::steady_clock::time_point lastEvent;
+            bool added; // first event was an Add, a Delete then cancels it out
+        };
+        std::mutex mutex;
+        std::chrono::milliseconds quietPeriod;
+        std::unordered_map<std::string, Pending> pending;
+    };
+
 /// A class that manages a queue of files added/modified or deleted fromthe filesystem 
 /// with both FIFO order and fast lookups
+/// push, pop, contains and remove are O(1), removed paths are left in the FIFO as stale
+/// entries and skipped when they reach the front. Owns its lock, callers need no other mutex
 class FileQueue {
     public:
         // Default constructor
@@ -42,17 +164,18 @@ class FileQueue {
         // Move constructor
         FileQueue(FileQueue&& other) noexcept {
             std::lock_guard<std::mutex> lock(other.mutex);
-            pathVector = std::move(other.pathVector);
-            pathMap = std::move(other.pathMap);
+            pathFifo = std::move(other.pathFifo);
+            pathTickets = std::move(other.pathTickets);
+            nextTicket = other.nextTicket;
         }
     
         // Move assignment operator
         FileQueue& operator=(FileQueue&& other) noexcept {
             if (this != &other) {
-                std::lock_guard<std::mutex> lock1(mutex);
-                std::lock_guard<std::mutex> lock2(other.mutex);
-                pathVector = std::move(other.pathVector);
-                pathMap = std::move(other.pathMap);
+                std::scoped_lock lock(mutex, other.mutex);
+                pathFifo = std::move(other.pathFifo);
+                pathTickets = std::move(other.pathTickets);
+                nextTicket = other.nextTicket;
             }
             return *this;
         }
@@ -64,102 +187,267 @@ class FileQueue {
         // Add a file to the queue if it's not already there
         bool push(const std::string& path) {
             std::lock_guard<std::mutex> lock(mutex);
-            if (pathMap.find(path) == pathMap.end()) {
-                pathVector.push_back(path);
-                pathMap[path] = true;
-                return true;
-            }
-            return false;
+            auto [found, inserted] = pathTickets.emplace(path, nextTicket);
+            if (!inserted) return false;
+            pathFifo.emplace_back(nextTicket++, path);
+            return true;
         }
     
         // Get the next file to process (FIFO order)
         bool pop(std::string& outPath) {
             std::lock_guard<std::mutex> lock(mutex);
-            if (!pathVector.empty()) {
-                outPath = pathVector.front();
-                pathVector.erase(pathVector.begin());
-                pathMap.erase(outPath);
-                return true;
-            }
-            return false;
+            if (!skipStale()) return false;
+            outPath = std::move(pathFifo.front().second);
+            pathTickets.erase(outPath);
+            pathFifo.pop_front();
+            return true;
         }
    
         // Get the next file to process (FIFO order)
         bool probe(std::string& outPath) {
             std::lock_guard<std::mutex> lock(mutex);
-            if (!pathVector.empty()) {
-                outPath = pathVector.front();
+            if (!skipStale()) return false;
+            outPath = pathFifo.front().second;
+            return true;
+        }        
+
+        // Take the first file in FIFO order that skip(path) does not reject,
+        // the skipped ones keep their place at the front
+        template <typename Skip>
+        bool popUnless(std::string& outPath, Skip skip) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!skipStale()) return false;
+            for (const auto& entry : pathFifo) {
+                if (!isLive(entry) || skip(entry.second)) continue;
+                outPath = entry.second;
+                pathTickets.erase(outPath); // the FIFO entry goes stale like remove()
                 return true;
             }
             return false;
-        }        
+        }
 
         // Remove a specific file by name
         bool remove(const std::string& path) {
             std::lock_guard<std::mutex> lock(mutex);
-            if (pathMap.find(path) != pathMap.end()) {
-                // Remove from vector using erase-remove idiom
-                pathVector.erase(
-                    std::remove(pathVector.begin(), pathVector.end(), path),
-                    pathVector.end()
-                );
-                // Remove from map
-                pathMap.erase(path);
-                return true;
+            if (pathTickets.erase(path) == 0) return false;
+            // The FIFO entry goes stale, compact once stale entries dominate
+            if (pathFifo.size() > 64 && pathFifo.size() > 2 * pathTickets.size()) {
+                std::deque<std::pair<uint64_t, std::string>> live;
+                for (auto& entry : pathFifo) {
+                    if (isLive(entry)) live.push_back(std::move(entry));
+                }
+                pathFifo.swap(live);
             }
-            return false;
+            return true;
         }
     
         // Check if a file exists in the queue
         bool contains(const std::string& path) const {
             std::lock_guard<std::mutex> lock(mutex);
-            return pathMap.find(path) != pathMap.end();
+            return pathTickets.find(path) != pathTickets.end();
         }
     
         // Get the number of files in the queue
         size_t size() const {
             std::lock_guard<std::mutex> lock(mutex);
-            return pathVector.size();
+            return pathTickets.size();
         }
     
         // Check if the queue is empty
         bool empty() const {
             std::lock_guard<std::mutex> lock(mutex);
-            return pathVector.empty();
+            return pathTickets.empty();
         }
     
         // Clear all files from the queue
         void clear() {
             std::lock_guard<std::mutex> lock(mutex);
-            pathVector.clear();
-            pathMap.clear();
+            pathFifo.clear();
+            pathTickets.clear();
         }
     
     private:
-        std::vector<std::string> pathVector;  // Maintains FIFO order
-        std::map<std::string, bool> pathMap;  // Enables fast lookups
+        // A FIFO entry is live while the path is queued with the same ticket,
+        // a path removed and pushed again gets a new ticket at the back
+        bool isLive(const std::pair<uint64_t, std::string>& entry) const {
+            auto found = pathTickets.find(entry.second);
+            return found != pathTickets.end() && found->second == entry.first;
+        }
+
+        // Drop stale entries at the front, false when the queue is empty
+        bool skipStale() {
+            while (!pathFifo.empty() && !isLive(pathFifo.front())) {
+                pathFifo.pop_front();
+            }
+            return !pathFifo.empty();
+        }
+
+        std::deque<std::pair<uint64_t, std::string>> pathFifo;  // Maintains FIFO order, ticket and path
+        std::unordered_map<std::string, uint64_t> pathTickets;   // Enables fast lookups, path to ticket
+        uint64_t nextTicket = 0;
         mutable std::mutex mutex;            // Thread safety
     };
 
+/// Queue of files where the lowest rank is taken first, equal ranks in FIFO order
+/// Dedupes like FileQueue, push, pop, contains and remove are O(log n). Owns its lock
+class PriorityFileQueue {
+    public:
+        PriorityFileQueue() = default;
+
+        PriorityFileQueue(const PriorityFileQueue&) = delete;
+        PriorityFileQueue& operator=(const PriorityFileQueue&) = delete;
+
+        // Add a file, a file already queued moves to its new rank
+        // @return true when the file was not queued yet
+        bool push(const std::string& path, int64_t rank) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = pathEntries.find(path);
+            bool inserted = found == pathEntries.end();
+            if (!inserted) order.erase(found->second);
+            pathEntries[path] = order.emplace(rank, nextTicket++, path).first;
+            return inserted;
+        }
+
+        // Get the file with the lowest rank
+        bool pop(std::string& outPath) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (order.empty()) return false;
+            outPath = std::get<2>(*order.begin());
+            pathEntries.erase(outPath);
+            order.erase(order.begin());
+            return true;
+        }
+
+        // Same file as pop() without taking it
+        bool probe(std::string& outPath) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (order.empty()) return false;
+            outPath = std::get<2>(*order.begin());
+            return true;
+        }
+
+        bool remove(const std::string& path) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = pathEntries.find(path);
+            if (found == pathEntries.end()) return false;
+            order.erase(found->second);
+            pathEntries.erase(found);
+            return true;
+        }
+
+        bool contains(const std::string& path) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return pathEntries.find(path) != pathEntries.end();
+        }
+
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return pathEntries.size();
+        }
+
+        bool empty() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return pathEntries.empty();
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.clear();
+            pathEntries.clear();
+        }
+
+    private:
+        typedef std::set<std::tuple<int64_t, uint64_t, std::string>> Order; // rank, ticket, path
+        Order order;
+        std::unordered_map<std::string, Order::iterator> pathEntries; // path to its entry in order
+        uint64_t nextTicket = 0;
+        mutable std::mutex mutex;
+    };
+
+/// Lock free multi producer, single consumer queue of paths
+/// Hands events from the efsw watcher threads to the main loop without either side blocking
+/// Any thread may push, only one thread may pop. No dedupe, the consumer pushes into a FileQueue
+class PathHandoffQueue {
+    public:
+        PathHandoffQueue() : head(new Node), tail(head.load()) {}
+
+        ~PathHandoffQueue() {
+            std::string discard;
+            while (pop(discard)) {}
+            delete tail;
+        }
+
+        PathHandoffQueue(const PathHandoffQueue&) = delete;
+        PathHandoffQueue& operator=(const PathHandoffQueue&) = delete;
+
+        // Safe from any thread
+        void push(const std::string& path) {
+            Node* node = new Node;
+            node->path = path;
+            Node* previous = head.exchange(node, std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        // Consumer thread only
+        // A push that is still linking its node is seen by the next pop
+        bool pop(std::string& outPath) {
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (!next) return false;
+            outPath = std::move(next->path);
+            delete tail;
+            tail = next; // next becomes the new empty stub
+            return true;
+        }
+
+    private:
+        struct Node {
+            std::atomic<Node*> next{nullptr};
+            std::string path;
+        };
+        std::atomic<Node*> head; // producers append here
+        Node* tail;              // consumer side, always an already consumed stub
+    };
+
 
 /// Processes a file action libefsw
 class UpdateListener : public efsw::FileWatchListener {
     public:
       // Modified constructor to take references to all FileQueue instances and mutexes
-      UpdateListener(FileQueue& fileQueue, FileQueue& unfileQueue, FileQueue& processQueue,
-                    std::mutex& fileQueueMutex, std::mutex& unfileQueueMutex, 
-                    std::mutex& processQueueMutex) 
+      // wakeSignal is notified after every queued file so the main loop can sleep until then
+      // fileQueue only gets files from flushQuiet() on the main loop, unfileQueue gets deletes
+      // straight from the watcher thread
+      UpdateListener(PathHandoffQueue& fileQueue, PathHandoffQueue& unfileQueue, WakeSignal& wakeSignal) 
           : fileQueue_(fileQueue), 
             unfileQueue_(unfileQueue),
-            processQueue_(processQueue),
-            fileQueueMutex_(fileQueueMutex),
-            unfileQueueMutex_(unfileQueueMutex),
-            processQueueMutex_(processQueueMutex),
+            wakeSignal_(wakeSignal),
             should_stop_(false) {}
   
       void stop() {
           should_stop_ = true;
       }
+
+      // How long a file has to go without events before it is queued
+      void setQuietPeriod(std::chrono::milliseconds quiet) {
+          debounce_.setQuietPeriod(quiet);
+      }
+
+      // Move files that stopped changing into fileQueue
+      // @param eventTimes: optional, gets the time of the first event of each queued file
+      // @return time until the next held file is due, milliseconds::max() when none is held
+      std::chrono::milliseconds flushQuiet(std::map<std::string, std::chrono::steady_clock::time_point>* eventTimes = nullptr) {
+          std::chrono::milliseconds nextDue;
+          std::vector<std::chrono::steady_clock::time_point> firstEvents;
+          std::vector<std::string> quietPaths = debounce_.takeQuiet(nextDue, &firstEvents);
+          for (size_t i = 0; i < quietPaths.size(); i++) {
+              const std::string& belPath = quietPaths[i];
+              if (eventTimes) eventTimes->emplace(belPath, firstEvents[i]); // keep the oldest if already queued
+              fileQueue_.push(belPath);
+              #ifdef _DEBUG
+                    std::cout << "\n==" << "QUEUED: " << belPath << "\n==" << std::endl;
+              #endif
+          }
+          return nextDue;
+      }
   
       std::string getActionName( efsw::Action action ) {
           switch ( action ) {
@@ -184,17 +472,27 @@ class UpdateListener : public efsw::FileWatchListener {
           if (should_stop_) return;  // Early exit if we're stopping
           
           std::string actionName = getActionName( action ); 
+          // contents1.vmaxb, scene.json and palettes are written inside the .vmax directory,
+          // any change in there keeps the whole .vmax held until the export is done
+          std::string vmaxPath = enclosingVmaxPath(dir + filename);
+          if (!vmaxPath.empty()) {
+              if (should_stop_) return;
+              // Children of a deleted .vmax can be reported after the directory itself,
+              // they must not queue a conversion of a path that is gone
+              std::error_code error;
+              if (!std::filesystem::is_directory(vmaxPath, error)) return;
+              debounce_.record(vmaxPath, DebounceStage::Event::Modified);
+              wakeSignal_.notify();
+              return;
+          }
           if (actionName == "Delete") { // always push to unfile queue, cpp will handle the rest
                 std::string belPath = dir + filename;
-                if (endsWith(belPath, ".bsz")) {
+                bool passOn = debounce_.record(belPath, DebounceStage::Event::Deleted);
+                if (passOn && (endsWith(belPath, ".bsz") || endsWith(belPath, ".vmax") || endsWith(belPath, ".zip"))) {
                     std::cout << "\n==" << "DELETE: " << dir + filename << "\n==" << std::endl;
-                    {
-                        std::lock_guard<std::mutex> lock(unfileQueueMutex_);
-                        if (!unfileQueue_.contains(belPath)) {
-                            unfileQueue_.push(belPath);
-                            std::cout << "\n==" << "STOP PROCESSING: " << belPath << "\n==" << std::endl;
-                        }
-                    }
+                    unfileQueue_.push(belPath); // renderUnqueue dedupes
+                    std::cout << "\n==" << "STOP PROCESSING: " << belPath << "\n==" << std::endl;
+                    wakeSignal_.notify();
                 }
           }
           if (actionName == "Add" || actionName == "Modified") {
@@ -204,26 +502,29 @@ class UpdateListener : public efsw::FileWatchListener {
               if (should_stop_) return;  // Check again before starting render
             
               if (endsWith(belPath, ".vmax") || endsWith(belPath, ".bsz") || endsWith(belPath, ".zip") && !endsWith(parentPath, "download/")) {
-                  {
-                      std::lock_guard<std::mutex> lock(fileQueueMutex_);
-                      if (!fileQueue_.contains(belPath)) {
-                          fileQueue_.push(belPath);
-                          #ifdef _DEBUG
-                                std::cout << "\n==" << "QUEUED: " << belPath << "\n==" << std::endl;
-                          #endif
-                      }
-                  }
+                  // Held until writes stop, see flushQuiet()
+                  debounce_.record(belPath, actionName == "Add" ? DebounceStage::Event::Added : DebounceStage::Event::Modified);
+                  wakeSignal_.notify();
               }
           }
       }
     private:
-      // Store references to all queues and mutexes
-      FileQueue& fileQueue_;
-      FileQueue& unfileQueue_;
-      FileQueue& processQueue_;
-      std::mutex& fileQueueMutex_;
-      std::mutex& unfileQueueMutex_;
-      std::mutex& processQueueMutex_;
+      // The .vmax directory a file is in, empty when it is not inside one
+      static std::string enclosingVmaxPath(const std::string& path) {
+          size_t found = std::string::npos;
+          for (const char* marker : {".vmax/", ".vmax\\"}) {
+              size_t at = path.rfind(marker);
+              if (at != std::string::npos && (found == std::string::npos || at > found)) found = at;
+          }
+          if (found == std::string::npos || found + 6 >= path.size()) return ""; // "foo.vmax/" is the directory itself
+          return path.substr(0, found + 5);
+      }
+
+      // Store references to the handoff queues
+      PathHandoffQueue& fileQueue_;
+      PathHandoffQueue& unfileQueue_;
+      WakeSignal& wakeSignal_;
+      DebounceStage debounce_; // between file events and fileQueue_
       std::atomic<bool> should_stop_; // ctrl-c was not working, so we use this to stop the thread
   };
 
@@ -5,6 +5,15 @@
 #include <filesystem>  // For std::filesystem
 //#include "DayEnvironmentHDRI019_1K-TONEMAPPED.h" // embedded image dome light
 #include <cmath>      // For std::pow
+#include <vector>     // For std::vector
+#include <thread>     // For std::thread
+#include <atomic>     // For std::atomic
+#include <mutex>      // For std::mutex
+#include <functional> // For std::function
+#include <exception>  // For std::exception_ptr
+#include <algorithm>  // For std::min
+#include <deque>      // For BoundedQueue
+#include <condition_variable> // For BoundedQueue
 
 //Forward declarations
 extern const unsigned int DayEnvironmentHDRI019_1K_TONEMAPPED_jpg_len;
@@ -17,6 +26,134 @@ inline float srgbToLinear(float value) {
            std::pow((value + 0.055f) * (1.0f/1.055f), 2.4f);
 }
 
+// Run fn(0) .. fn(count-1) on a small pool of worker threads
+// Work is handed out one index at a time so uneven jobs balance themselves
+// @param count: number of work items
+// @param jobs: max number of threads, 0 uses every hardware thread
+// @param fn: work item, must be safe to call concurrently
+// The first exception thrown by fn is rethrown on the calling thread once all workers are done
+inline void runParallel(size_t count, unsigned jobs, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(std::min<size_t>(jobs, count));
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError) firstError = std::current_exception();
+                next = count; // stop handing out work
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < jobs; t++) {
+        workers.emplace_back(worker);
+    }
+    worker(); // calling thread is one of the workers
+    for (auto& eachWorker : workers) {
+        eachWorker.join();
+    }
+    if (firstError) std::rethrow_exception(firstError);
+}
+
+// Fixed capacity FIFO between pipeline stages running on different threads
+// push blocks while full, pop blocks while empty, close() releases everyone waiting
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t maxItems) : capacity(std::max<size_t>(1, maxItems)) {
+    }
+
+    // Block until there is room, false if the queue was closed
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Never blocks, false if the queue is full or closed
+    bool tryPush(T item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed || items.size() >= capacity) return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Block until there is an item, false once the queue is closed and drained
+    bool pop(T& outItem) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        outItem = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Never blocks, false if the queue is empty
+    bool tryPop(T& outItem) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) return false;
+        outItem = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    bool full() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size() >= capacity;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+};
+
+// Shell style wildcard match of a whole name, * is any run of characters and ? any one character
+inline bool globMatch(const std::string& pattern, const std::string& name) {
+    size_t p = 0, n = 0;
+    size_t starP = std::string::npos, starN = 0; // last * seen, retried with one more character each miss
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            p++;
+            n++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            starP = p++;
+            starN = n;
+        } else if (starP != std::string::npos) {
+            p = starP + 1;
+            n = ++starN;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') p++;
+    return p == pattern.size();
+}
+
 // read binary compressed LZFSE file into an array
 inline std::vector<uint8_t> LZFSEToArray(const std::string& lzfseFullName) {
         std::ifstream lzfseFile(lzfseFullName, std::ios::binary);
@@ -12,13 +12,325 @@
 #include <fstream>      // For file operations (reading/writing files)
 #include <iostream>     // For input/output operations (cout, cin, etc.)
 #include <filesystem>   // For file system operations (directory handling, path manipulation)
+#include <array>        // For fixed size material tables
+#include <stdexcept>    // For std::runtime_error
+#include <algorithm>    // For std::min
+#include <cstring>      // For std::memcpy
+#include <cstdio>       // For snprintf
+#include <memory>       // For std::shared_ptr
+#include <mutex>        // For std::mutex guarding the model cache
+#include <deque>        // For the model cache eviction order
+#include <unordered_map> // For the model cache
+#include <atomic>       // For the lock free pipeline counters
+#include <chrono>       // For stage timers
+#include <random>       // For unique temporary file names
+
+#include <iterator>     // For std::istreambuf_iterator
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX        // keep std::min/std::max usable
+#endif
+#include <windows.h>    // For CreateFileMapping, MapViewOfFile
+#else
+#include <fcntl.h>      // For open
+#include <sys/mman.h>   // For mmap
+#include <sys/stat.h>   // For fstat
+#include <unistd.h>     // For close
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>     // For __cpuidex, _BitScanForward64
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>  // For _pext_u32 (BMI2)
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>   // For NEON table lookups
+#endif
 
 #include "../lzfse/src/lzfse.h"
+#include "oomer_misc.h"  // For srgbToLinear
 #include "../libplist/include/plist/plist.h" // Library for handling Apple property list files
 #include "thirdparty/json.hpp"
 
 using json = nlohmann::json;
 
+// Counters and timers of the conversion pipeline, see --stats
+// Process wide and lock free, every stage adds to them from whatever thread it runs on
+struct VmaxStats {
+    // readPlist
+    std::atomic<uint64_t> plistFiles{0};
+    std::atomic<uint64_t> plistBytesIn{0};      // file bytes
+    std::atomic<uint64_t> plistBytesOut{0};     // bytes handed to the plist parser, decompressed
+    std::atomic<uint64_t> lzfseRetries{0};      // extra decodes when the decoded size was not known
+    std::atomic<uint64_t> plistNanos{0};
+    // Snapshot walk
+    std::atomic<uint64_t> snapshots{0};
+    std::atomic<uint64_t> snapshotsSuperseded{0}; // a later snapshot of the same chunk was decoded instead
+    std::atomic<uint64_t> snapshotsExcluded{0};   // past --snapshot, outside --region or without a chunk id
+    // Voxel decode
+    std::atomic<uint64_t> voxelsDecoded{0};
+    std::atomic<uint64_t> voxelDecodeNanos{0};
+    // --merge-colors, buckets of decoded models before and after merging
+    std::atomic<uint64_t> mergeBucketsIn{0};
+    std::atomic<uint64_t> mergeBucketsOut{0};
+    std::atomic<uint64_t> mergeVoxelsMoved{0};  // voxels that changed color
+    // Model cache
+    std::atomic<uint64_t> modelsDecoded{0};
+    std::atomic<uint64_t> modelsCached{0};
+    // addModelToScene
+    std::atomic<uint64_t> buckets{0};           // instancers or meshes, one per material/color
+    std::atomic<uint64_t> instances{0};
+    std::atomic<uint64_t> maxInstancesPerBucket{0};
+    std::atomic<uint64_t> instancesPerBucketLog2[33] = {}; // histogram, bin n counts buckets with 2^(n-1) < instances <= 2^n, bin 0 is 0 or 1
+    std::atomic<uint64_t> meshQuads{0};
+    std::atomic<uint64_t> materials{0};         // quickMaterial nodes created
+    std::atomic<uint64_t> materialsShared{0};   // buckets that reused an equal material of another model
+    std::atomic<uint64_t> sceneBuildNanos{0};
+    // belScene.write
+    std::atomic<uint64_t> sceneWrites{0};
+    std::atomic<uint64_t> sceneWriteNanos{0};
+    // Watch queue, first file event to conversion or render start
+    std::atomic<uint64_t> queuedFiles{0};
+    std::atomic<uint64_t> queueLatencyNanos{0};
+    std::atomic<uint64_t> maxQueueLatencyNanos{0};
+
+    static void addMax(std::atomic<uint64_t>& target, uint64_t value) {
+        uint64_t current = target.load(std::memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+
+    void addBucket(uint64_t bucketInstances) {
+        buckets++;
+        instances += bucketInstances;
+        addMax(maxInstancesPerBucket, bucketInstances);
+        int bin = 0;
+        while (bin < 32 && (uint64_t(1) << bin) < bucketInstances) bin++;
+        instancesPerBucketLog2[bin]++;
+    }
+
+    void addQueueLatency(std::chrono::steady_clock::duration latency) {
+        uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+        queuedFiles++;
+        queueLatencyNanos += nanos;
+        addMax(maxQueueLatencyNanos, nanos);
+    }
+
+    json toJson() const {
+        auto ms = [](const std::atomic<uint64_t>& nanos) { return nanos.load() / 1e6; };
+        auto perSecond = [](uint64_t amount, uint64_t nanos) { return nanos ? amount / (nanos / 1e9) : 0.0; };
+        json histogram = json::array();
+        for (const auto& bin : instancesPerBucketLog2) histogram.push_back(bin.load());
+        return json{
+            {"readPlist", {{"files", plistFiles.load()}, {"bytesIn", plistBytesIn.load()}, {"bytesOut", plistBytesOut.load()},
+                           {"lzfseRetries", lzfseRetries.load()}, {"ms", ms(plistNanos)},
+                           {"bytesOutPerSec", perSecond(plistBytesOut, plistNanos)}}},
+            {"snapshots", {{"total", snapshots.load()}, {"superseded", snapshotsSuperseded.load()},
+                           {"excluded", snapshotsExcluded.load()}}},
+            {"voxelDecode", {{"voxels", voxelsDecoded.load()}, {"ms", ms(voxelDecodeNanos)},
+                             {"voxelsPerSec", perSecond(voxelsDecoded, voxelDecodeNanos)}}},
+            {"mergeColors", {{"bucketsIn", mergeBucketsIn.load()}, {"bucketsOut", mergeBucketsOut.load()},
+                             {"voxelsMoved", mergeVoxelsMoved.load()}}},
+            {"models", {{"decoded", modelsDecoded.load()}, {"cached", modelsCached.load()}}},
+            {"addModelToScene", {{"buckets", buckets.load()}, {"instances", instances.load()},
+                                 {"maxInstancesPerBucket", maxInstancesPerBucket.load()},
+                                 {"instancesPerBucketLog2", histogram}, {"meshQuads", meshQuads.load()},
+                                 {"materials", materials.load()}, {"materialsShared", materialsShared.load()},
+                                 {"ms", ms(sceneBuildNanos)}}},
+            {"sceneWrite", {{"writes", sceneWrites.load()}, {"ms", ms(sceneWriteNanos)}}},
+            {"watchQueue", {{"files", queuedFiles.load()},
+                            {"avgLatencyMs", queuedFiles ? ms(queueLatencyNanos) / queuedFiles.load() : 0.0},
+                            {"maxLatencyMs", ms(maxQueueLatencyNanos)}}}
+        };
+    }
+
+    // Instancers going into addModelToScene with and without --merge-colors
+    void printMergeColors(std::ostream& out) const {
+        char line[256];
+        snprintf(line, sizeof(line), "%-16s %8llu buckets in  %8llu out  %12llu voxels moved",
+                 "merge colors", (unsigned long long)mergeBucketsIn.load(), (unsigned long long)mergeBucketsOut.load(),
+                 (unsigned long long)mergeVoxelsMoved.load());
+        out << line << std::endl;
+    }
+
+    void print(std::ostream& out) const {
+        json j = toJson();
+        char line[256];
+        out << "== stats ==" << std::endl;
+        snprintf(line, sizeof(line), "%-16s %8llu files  %10.1f MB in  %10.1f MB out  %4llu retries  %9.1f ms  %8.1f MB/s",
+                 "readPlist", (unsigned long long)plistFiles.load(), plistBytesIn / 1e6, plistBytesOut / 1e6,
+                 (unsigned long long)lzfseRetries.load(), j["readPlist"]["ms"].get<double>(),
+                 j["readPlist"]["bytesOutPerSec"].get<double>() / 1e6);
+        out << line << std::endl;
+        snprintf(line, sizeof(line), "%-16s %8llu total  %8llu superseded  %8llu excluded",
+                 "snapshots", (unsigned long long)snapshots.load(), (unsigned long long)snapshotsSuperseded.load(),
+                 (unsigned long long)snapshotsExcluded.load());
+        out << line << std::endl;
+        snprintf(line, sizeof(line), "%-16s %12llu voxels  %9.1f ms  %8.1f M voxels/s",
+                 "voxel decode", (unsigned long long)voxelsDecoded.load(), j["voxelDecode"]["ms"].get<double>(),
+                 j["voxelDecode"]["voxelsPerSec"].get<double>() / 1e6);
+        out << line << std::endl;
+        printMergeColors(out);
+        snprintf(line, sizeof(line), "%-16s %8llu decoded  %8llu cached",
+                 "models", (unsigned long long)modelsDecoded.load(), (unsigned long long)modelsCached.load());
+        out << line << std::endl;
+        snprintf(line, sizeof(line), "%-16s %8llu buckets  %12llu instances  %10llu max/bucket  %10llu quads  %9.1f ms",
+                 "addModelToScene", (unsigned long long)buckets.load(), (unsigned long long)instances.load(),
+                 (unsigned long long)maxInstancesPerBucket.load(), (unsigned long long)meshQuads.load(),
+                 j["addModelToScene"]["ms"].get<double>());
+        out << line << std::endl;
+        snprintf(line, sizeof(line), "%-16s %8llu created  %8llu shared",
+                 "materials", (unsigned long long)materials.load(), (unsigned long long)materialsShared.load());
+        out << line << std::endl;
+        snprintf(line, sizeof(line), "%-16s %8llu writes  %9.1f ms",
+                 "scene write", (unsigned long long)sceneWrites.load(), j["sceneWrite"]["ms"].get<double>());
+        out << line << std::endl;
+        snprintf(line, sizeof(line), "%-16s %8llu files  %9.1f ms avg latency  %9.1f ms max",
+                 "watch queue", (unsigned long long)queuedFiles.load(), j["watchQueue"]["avgLatencyMs"].get<double>(),
+                 j["watchQueue"]["maxLatencyMs"].get<double>());
+        out << line << std::endl;
+    }
+};
+
+inline VmaxStats& vmaxStats() {
+    static VmaxStats stats;
+    return stats;
+}
+
+// Adds the time from construction to destruction to a VmaxStats timer
+class VmaxStatTimer {
+public:
+    explicit VmaxStatTimer(std::atomic<uint64_t>& nanos) : target(nanos), start(std::chrono::steady_clock::now()) {
+    }
+    ~VmaxStatTimer() {
+        target += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+    VmaxStatTimer(const VmaxStatTimer&) = delete;
+    VmaxStatTimer& operator=(const VmaxStatTimer&) = delete;
+private:
+    std::atomic<uint64_t>& target;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Bump allocator for scratch memory that dies with a conversion
+// Memory comes from a few large blocks, freeing single allocations is a no op
+// rewind() hands everything after a mark back for reuse, the blocks stay allocated
+// release() frees the blocks, done once the scene is written so watch mode does not grow
+class VmaxArena {
+public:
+    explicit VmaxArena(size_t blockSize = 1 << 20) : minBlockSize(blockSize) {
+    }
+    VmaxArena(const VmaxArena&) = delete;
+    VmaxArena& operator=(const VmaxArena&) = delete;
+
+    struct Mark {
+        size_t block = 0;
+        size_t used = 0;
+    };
+
+    void* allocate(size_t size, size_t align) {
+        while (current < blocks.size()) {
+            Block& block = blocks[current];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            size_t at = static_cast<size_t>(((base + used + align - 1) & ~static_cast<uintptr_t>(align - 1)) - base);
+            if (at + size <= block.size) {
+                used = at + size;
+                return block.data.get() + at;
+            }
+            if (current + 1 == blocks.size()) break;
+            current++; // blocks kept from before a rewind are reused in order
+            used = 0;
+        }
+        // Oversized requests like a whole decoded plist get a block of their own
+        size_t blockSize = std::max(minBlockSize, size + align);
+        Block block;
+        block.data.reset(new uint8_t[blockSize]);
+        block.size = blockSize;
+        if (!blocks.empty()) current++;
+        blocks.insert(blocks.begin() + current, std::move(block));
+        used = 0;
+        return allocate(size, align);
+    }
+
+    Mark mark() const {
+        Mark m;
+        m.block = current;
+        m.used = used;
+        return m;
+    }
+    void rewind(const Mark& m) {
+        current = m.block;
+        used = m.used;
+    }
+    void release() {
+        blocks.clear();
+        current = 0;
+        used = 0;
+    }
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& block : blocks) total += block.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size = 0;
+    };
+    std::vector<Block> blocks;
+    size_t current = 0; // block allocations are taken from
+    size_t used = 0;    // bytes used in blocks[current]
+    size_t minBlockSize;
+};
+
+// STL allocator over a VmaxArena, containers using it must not outlive the next rewind
+template <typename T>
+struct VmaxArenaAllocator {
+    typedef T value_type;
+    VmaxArena* arena;
+
+    explicit VmaxArenaAllocator(VmaxArena& a) : arena(&a) {
+    }
+    template <typename U>
+    VmaxArenaAllocator(const VmaxArenaAllocator<U>& other) : arena(other.arena) {
+    }
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) {
+    }
+    template <typename U>
+    bool operator==(const VmaxArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const VmaxArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using VmaxArenaVector = std::vector<T, VmaxArenaAllocator<T>>;
+
+// Scratch arena of the calling thread, like lzfseScratch() one per decode worker
+// Workers started by runParallel() free theirs when they exit, the converting thread
+// keeps its own until the scene is written, see VmaxArena::release()
+inline VmaxArena& vmaxThreadArena() {
+    thread_local VmaxArena arena;
+    return arena;
+}
+
+// Rewinds an arena to where it was at construction, declare before the containers it backs
+class VmaxArenaScope {
+public:
+    explicit VmaxArenaScope(VmaxArena& a) : arena(a), start(a.mark()) {
+    }
+    ~VmaxArenaScope() {
+        arena.rewind(start);
+    }
+    VmaxArenaScope(const VmaxArenaScope&) = delete;
+    VmaxArenaScope& operator=(const VmaxArenaScope&) = delete;
+private:
+    VmaxArena& arena;
+    VmaxArena::Mark start;
+};
+
 // Define STB_IMAGE_IMPLEMENTATION before including to create the implementation
 #define STB_IMAGE_IMPLEMENTATION
 #include "thirdparty/stb_image.h" // STB Image library
@@ -143,41 +455,12 @@ struct VmaxRGBA {
     uint8_t r, g, b, a;
 };
 
-// Read a 256x1 PNG file and return a vector of VmaxRGBA colors
-std::vector<VmaxRGBA> read256x1PaletteFromPNG(const std::string& filename) {
-    int width, height, channels;
-    // Load the image with 4 desired channels (RGBA)
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 4);
-    
-    if (!data) {
-        std::cerr << "Error loading PNG file: " << filename << std::endl;
-        return {};
-    }
-    // Make sure the image is 256x1 as expected
-    if (width != 256 || height != 1) {
-        std::cerr << "Warning: Expected a 256x1 image, but got " << width << "x" << height << std::endl;
-    }
-    // Create our palette array
-    std::vector<VmaxRGBA> palette;
-    // Read each pixel (each pixel is 4 bytes - RGBA)
-    for (int i = 0; i < width; i++) {
-        VmaxRGBA color;
-        color.r = data[i * 4];
-        color.g = data[i * 4 + 1];
-        color.b = data[i * 4 + 2];
-        color.a = data[i * 4 + 3];
-        palette.push_back(color);
-    }
-    stbi_image_free(data); // Free the image data
-    return palette;
-}
-
 // Standard useful voxel structure, maps easily to VoxelMax's voxel structure and probably MagicaVoxel's
 // We are using this to unpack a chunked voxel into a simple giant voxel
 // using a uint8_t saves memory over a uint32_t and both VM and MV models are 256x256x256
 // The world itself can be larger, see scene.json
-// Helper struct because in VmaxModel we use array of arrays to store material and color
-// Allowing us to group voxels by material and color
+// Used for flat voxel lists (decodeVoxels, vmaxVoxelInfo), VmaxModel itself stores
+// packed positions grouped by material and color, see packVoxelPosition()
 struct VmaxVoxel {
     uint8_t x, y, z;
     uint8_t material;    // material value 0-7
@@ -213,6 +496,190 @@ inline void decodeMorton3DOptimized(uint32_t morton, uint32_t& x, uint32_t& y, u
     z = compactBits(morton >> 2);
 }
 
+// Inverse of compactBits, 10 bits spread to every 3rd bit
+inline uint32_t spreadBits(uint32_t n) {
+    n &= 0x000003ff;
+    n = (n ^ (n << 16)) & 0xff0000ff;
+    n = (n ^ (n << 8)) & 0x0300f00f;
+    n = (n ^ (n << 4)) & 0x030c30c3;
+    n = (n ^ (n << 2)) & 0x09249249;
+    return n;
+}
+
+// Morton code of x, y, z, inverse of decodeMorton3DOptimized
+inline uint32_t encodeMorton3D(uint32_t x, uint32_t y, uint32_t z) {
+    return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+// Batched Morton decoding
+// ds pairs are stored at consecutive morton codes, so a whole run can be decoded at once
+// All decoders handle codes up to 24 bits (8 bits per axis, the 256x256x256 model volume)
+// @param first: morton code of the first element
+// @param count: number of consecutive codes to decode
+// @param x, y, z: output arrays with room for count values
+typedef void (*MortonBatchDecoder)(uint32_t first, size_t count, uint8_t* x, uint8_t* y, uint8_t* z);
+
+// Consecutive codes in an 8 aligned run share every bit above the lowest 3,
+// so a run is one base decode plus a fixed pattern for the low bit of each axis
+// Patterns are 8 little endian bytes, byte k holds the low bit of code base+k
+constexpr uint64_t kMortonRunX = 0x0100010001000100ull; // k & 1
+constexpr uint64_t kMortonRunY = 0x0101000001010000ull; // (k >> 1) & 1
+constexpr uint64_t kMortonRunZ = 0x0101010100000000ull; // (k >> 2) & 1
+
+// Write one run of 8 decoded codes given the decoded base (base & 7 == 0)
+inline void storeMortonRun8(uint32_t baseX, uint32_t baseY, uint32_t baseZ, uint8_t* x, uint8_t* y, uint8_t* z) {
+    uint64_t runX = baseX * 0x0101010101010101ull | kMortonRunX;
+    uint64_t runY = baseY * 0x0101010101010101ull | kMortonRunY;
+    uint64_t runZ = baseZ * 0x0101010101010101ull | kMortonRunZ;
+    std::memcpy(x, &runX, 8);
+    std::memcpy(y, &runY, 8);
+    std::memcpy(z, &runZ, 8);
+}
+
+// Portable incremental decoder, one full bit compaction per 8 codes
+inline void decodeMorton3DBatchScalar(uint32_t first, size_t count, uint8_t* x, uint8_t* y, uint8_t* z) {
+    size_t i = 0;
+    auto decodeOne = [&](size_t n) {
+        uint32_t morton = first + static_cast<uint32_t>(n);
+        x[n] = static_cast<uint8_t>(compactBits(morton));
+        y[n] = static_cast<uint8_t>(compactBits(morton >> 1));
+        z[n] = static_cast<uint8_t>(compactBits(morton >> 2));
+    };
+    for (; i < count && ((first + i) & 7); i++) decodeOne(i); // up to the first aligned run
+    for (; i + 8 <= count; i += 8) {
+        uint32_t morton = first + static_cast<uint32_t>(i);
+        storeMortonRun8(compactBits(morton), compactBits(morton >> 1), compactBits(morton >> 2), x + i, y + i, z + i);
+    }
+    for (; i < count; i++) decodeOne(i); // partial run at the end
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+// BMI2 decoder, same runs as the scalar decoder with parallel bit extract for each base
+// Note: pre Zen3 AMD cores implement pext in microcode so the scalar decoder is about as fast there
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("bmi2")))
+#endif
+inline void decodeMorton3DBatchBMI2(uint32_t first, size_t count, uint8_t* x, uint8_t* y, uint8_t* z) {
+    const uint32_t maskX = 0x00249249, maskY = 0x00492492, maskZ = 0x00924924;
+    size_t i = 0;
+    for (; i < count && ((first + i) & 7); i++) {
+        uint32_t morton = first + static_cast<uint32_t>(i);
+        x[i] = static_cast<uint8_t>(_pext_u32(morton, maskX));
+        y[i] = static_cast<uint8_t>(_pext_u32(morton, maskY));
+        z[i] = static_cast<uint8_t>(_pext_u32(morton, maskZ));
+    }
+    for (; i + 8 <= count; i += 8) {
+        uint32_t morton = first + static_cast<uint32_t>(i);
+        storeMortonRun8(_pext_u32(morton, maskX), _pext_u32(morton, maskY), _pext_u32(morton, maskZ), x + i, y + i, z + i);
+    }
+    for (; i < count; i++) {
+        uint32_t morton = first + static_cast<uint32_t>(i);
+        x[i] = static_cast<uint8_t>(_pext_u32(morton, maskX));
+        y[i] = static_cast<uint8_t>(_pext_u32(morton, maskY));
+        z[i] = static_cast<uint8_t>(_pext_u32(morton, maskZ));
+    }
+}
+
+inline bool cpuHasBMI2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 8)) != 0;
+#else
+    return __builtin_cpu_supports("bmi2");
+#endif
+}
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+// NEON decoder, 16 codes per iteration
+// The 24 bit code is split into four 6 bit groups, each group holds 2 bits per axis
+// and is resolved with a 64 byte table lookup (vqtbl4q_u8) per axis
+inline void decodeMorton3DBatchNEON(uint32_t first, size_t count, uint8_t* x, uint8_t* y, uint8_t* z) {
+    static const struct MortonNeonTables {
+        uint8_t x[64], y[64], z[64];
+        MortonNeonTables() {
+            for (uint32_t i = 0; i < 64; i++) {
+                x[i] = static_cast<uint8_t>(compactBits(i));
+                y[i] = static_cast<uint8_t>(compactBits(i >> 1));
+                z[i] = static_cast<uint8_t>(compactBits(i >> 2));
+            }
+        }
+    } tables;
+    const uint8x16x4_t tx = {{ vld1q_u8(tables.x), vld1q_u8(tables.x + 16), vld1q_u8(tables.x + 32), vld1q_u8(tables.x + 48) }};
+    const uint8x16x4_t ty = {{ vld1q_u8(tables.y), vld1q_u8(tables.y + 16), vld1q_u8(tables.y + 32), vld1q_u8(tables.y + 48) }};
+    const uint8x16x4_t tz = {{ vld1q_u8(tables.z), vld1q_u8(tables.z + 16), vld1q_u8(tables.z + 32), vld1q_u8(tables.z + 48) }};
+    static const uint32_t laneOffsets[16] = {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15};
+    const uint32x4_t lanes0 = vld1q_u32(laneOffsets);
+    const uint32x4_t lanes1 = vld1q_u32(laneOffsets + 4);
+    const uint32x4_t lanes2 = vld1q_u32(laneOffsets + 8);
+    const uint32x4_t lanes3 = vld1q_u32(laneOffsets + 12);
+    const uint32x4_t mask6 = vdupq_n_u32(63);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint32x4_t base = vdupq_n_u32(first + static_cast<uint32_t>(i));
+        uint32x4_t m0 = vaddq_u32(base, lanes0);
+        uint32x4_t m1 = vaddq_u32(base, lanes1);
+        uint32x4_t m2 = vaddq_u32(base, lanes2);
+        uint32x4_t m3 = vaddq_u32(base, lanes3);
+        // narrow 16 codes, pre-shifted by 6*group, to 16 table indices
+        #define OOMER_MORTON_GROUP(shift) vcombine_u8( \
+            vmovn_u16(vcombine_u16(vmovn_u32(vandq_u32(vshrq_n_u32(m0, shift), mask6)), \
+                                   vmovn_u32(vandq_u32(vshrq_n_u32(m1, shift), mask6)))), \
+            vmovn_u16(vcombine_u16(vmovn_u32(vandq_u32(vshrq_n_u32(m2, shift), mask6)), \
+                                   vmovn_u32(vandq_u32(vshrq_n_u32(m3, shift), mask6)))))
+        uint8x16_t g0 = vcombine_u8(
+            vmovn_u16(vcombine_u16(vmovn_u32(vandq_u32(m0, mask6)), vmovn_u32(vandq_u32(m1, mask6)))),
+            vmovn_u16(vcombine_u16(vmovn_u32(vandq_u32(m2, mask6)), vmovn_u32(vandq_u32(m3, mask6)))));
+        uint8x16_t g1 = OOMER_MORTON_GROUP(6);
+        uint8x16_t g2 = OOMER_MORTON_GROUP(12);
+        uint8x16_t g3 = OOMER_MORTON_GROUP(18);
+        #undef OOMER_MORTON_GROUP
+        vst1q_u8(x + i, vorrq_u8(vorrq_u8(vqtbl4q_u8(tx, g0), vshlq_n_u8(vqtbl4q_u8(tx, g1), 2)),
+                                 vorrq_u8(vshlq_n_u8(vqtbl4q_u8(tx, g2), 4), vshlq_n_u8(vqtbl4q_u8(tx, g3), 6))));
+        vst1q_u8(y + i, vorrq_u8(vorrq_u8(vqtbl4q_u8(ty, g0), vshlq_n_u8(vqtbl4q_u8(ty, g1), 2)),
+                                 vorrq_u8(vshlq_n_u8(vqtbl4q_u8(ty, g2), 4), vshlq_n_u8(vqtbl4q_u8(ty, g3), 6))));
+        vst1q_u8(z + i, vorrq_u8(vorrq_u8(vqtbl4q_u8(tz, g0), vshlq_n_u8(vqtbl4q_u8(tz, g1), 2)),
+                                 vorrq_u8(vshlq_n_u8(vqtbl4q_u8(tz, g2), 4), vshlq_n_u8(vqtbl4q_u8(tz, g3), 6))));
+    }
+    if (i < count) {
+        decodeMorton3DBatchScalar(first + static_cast<uint32_t>(i), count - i, x + i, y + i, z + i);
+    }
+}
+#endif
+
+// Picks the fastest decoder for this cpu, once, the first time a batch is decoded
+inline MortonBatchDecoder selectMortonBatchDecoder(const char** name = nullptr) {
+    const char* selected = "scalar";
+    MortonBatchDecoder decoder = decodeMorton3DBatchScalar;
+#if defined(__aarch64__) || defined(_M_ARM64)
+    selected = "neon";
+    decoder = decodeMorton3DBatchNEON; // NEON is part of every arm64 cpu
+#elif defined(__x86_64__) || defined(_M_X64)
+    if (cpuHasBMI2()) {
+        selected = "bmi2";
+        decoder = decodeMorton3DBatchBMI2;
+    }
+#endif
+    if (name) *name = selected;
+    return decoder;
+}
+
+// Name of the decoder in use, handy for logs and benchmarks
+inline const char* mortonBatchDecoderName() {
+    static const char* name = nullptr;
+    static const MortonBatchDecoder decoder = selectMortonBatchDecoder(&name);
+    (void)decoder;
+    return name;
+}
+
+// Decode a run of consecutive morton codes with the best decoder for this cpu
+inline void decodeMorton3DBatch(uint32_t first, size_t count, uint8_t* x, uint8_t* y, uint8_t* z) {
+    static const MortonBatchDecoder decoder = selectMortonBatchDecoder();
+    decoder(first, count, x, y, z);
+}
+
 struct VmaxMaterial {
     std::string materialName;
     double transmission;
@@ -224,15 +691,167 @@ struct VmaxMaterial {
     bool volumetric; // future use
 };
 
+// Voxel position packed into 24 bits, x | y << 8 | z << 16, in 256x256x256 model space
+inline uint32_t packVoxelPosition(uint32_t x, uint32_t y, uint32_t z) {
+    return (x & 0xff) | ((y & 0xff) << 8) | ((z & 0xff) << 16);
+}
+
+inline void unpackVoxelPosition(uint32_t packed, uint32_t& x, uint32_t& y, uint32_t& z) {
+    x = packed & 0xff;
+    y = (packed >> 8) & 0xff;
+    z = (packed >> 16) & 0xff;
+}
+
+// Bucket key for a material (0-7) and color (1-255) pair, material << 8 | color
+inline uint16_t vmaxBucketKey(int material, int color) {
+    return static_cast<uint16_t>((material << 8) | color);
+}
+
+// Read only view of the packed positions of one material/color bucket
+struct VmaxVoxelSpan {
+    const uint32_t* first = nullptr;
+    const uint32_t* last = nullptr;
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+// Two level occupancy index of the 256x256x256 model volume
+// Level 1: a 512 bit mask of the occupied 32x32x32 chunks (8x8x8 chunks, see the format spec)
+// Level 2: a 32x32x32 bit brick per occupied chunk, only allocated for occupied chunks
+// Gives O(1) "is there a voxel at x,y,z" and iteration over occupied chunks only
+struct VmaxOccupancy {
+    static constexpr int kChunkSize = 32;    // voxels per chunk axis
+    static constexpr int kChunksPerAxis = 8; // chunks per model axis
+    static constexpr int kModelSize = kChunkSize * kChunksPerAxis;
+
+    // One row of 32 voxels along x per (y, z), bit x set when occupied, row index y + z * 32
+    typedef std::array<uint32_t, kChunkSize * kChunkSize> Brick;
+
+    VmaxOccupancy() {
+        brickIndex.fill(-1);
+    }
+
+    // Chunk index used by the mask and brick table, cx | cy << 3 | cz << 6
+    static int chunkIndex(int cx, int cy, int cz) {
+        return cx | (cy << 3) | (cz << 6);
+    }
+
+    // Mark a voxel as occupied, position in model space 0-255
+    void set(uint32_t x, uint32_t y, uint32_t z) {
+        x &= 0xff; y &= 0xff; z &= 0xff;
+        int chunk = chunkIndex(x >> 5, y >> 5, z >> 5);
+        if (brickIndex[chunk] < 0) {
+            brickIndex[chunk] = static_cast<int16_t>(bricks.size());
+            bricks.emplace_back();
+            bricks.back().fill(0);
+            chunkMask[chunk >> 6] |= uint64_t(1) << (chunk & 63);
+        }
+        bricks[brickIndex[chunk]][(y & 31) + (z & 31) * kChunkSize] |= uint32_t(1) << (x & 31);
+        if (voxelCount++ == 0) {
+            minX = maxX = static_cast<uint8_t>(x);
+            minY = maxY = static_cast<uint8_t>(y);
+            minZ = maxZ = static_cast<uint8_t>(z);
+        } else {
+            minX = std::min<uint8_t>(minX, x); maxX = std::max<uint8_t>(maxX, x);
+            minY = std::min<uint8_t>(minY, y); maxY = std::max<uint8_t>(maxY, y);
+            minZ = std::min<uint8_t>(minZ, z); maxZ = std::max<uint8_t>(maxZ, z);
+        }
+    }
+
+    // Is there a voxel at x,y,z, anything outside the model volume is empty
+    bool test(int x, int y, int z) const {
+        if (x < 0 || y < 0 || z < 0 || x >= kModelSize || y >= kModelSize || z >= kModelSize) return false;
+        int16_t brick = brickIndex[chunkIndex(x >> 5, y >> 5, z >> 5)];
+        if (brick < 0) return false;
+        return (bricks[brick][(y & 31) + (z & 31) * kChunkSize] >> (x & 31)) & 1;
+    }
+
+    // 32 voxels along x starting at chunk column cx * 32, bit i is x = cx * 32 + i
+    uint32_t row(int cx, int y, int z) const {
+        if (cx < 0 || y < 0 || z < 0 || cx >= kChunksPerAxis || y >= kModelSize || z >= kModelSize) return 0;
+        int16_t brick = brickIndex[chunkIndex(cx, y >> 5, z >> 5)];
+        return brick < 0 ? 0 : bricks[brick][(y & 31) + (z & 31) * kChunkSize];
+    }
+
+    bool chunkOccupied(int cx, int cy, int cz) const {
+        int chunk = chunkIndex(cx, cy, cz);
+        return (chunkMask[chunk >> 6] >> (chunk & 63)) & 1;
+    }
+
+    // Brick of an occupied chunk, nullptr when the chunk is empty
+    const Brick* brick(int cx, int cy, int cz) const {
+        int16_t index = brickIndex[chunkIndex(cx, cy, cz)];
+        return index < 0 ? nullptr : &bricks[index];
+    }
+
+    // Visit occupied chunks only, fn(cx, cy, cz, const Brick&)
+    template <typename Fn>
+    void forEachOccupiedChunk(Fn&& fn) const {
+        for (int word = 0; word < 8; word++) {
+            uint64_t bits = chunkMask[word];
+            while (bits) {
+                int chunk = word * 64 + countTrailingZeros(bits);
+                bits &= bits - 1;
+                fn(chunk & 7, (chunk >> 3) & 7, chunk >> 6, bricks[brickIndex[chunk]]);
+            }
+        }
+    }
+
+    // Number of set() calls, duplicates included
+    size_t count() const { return voxelCount; }
+    size_t memoryBytes() const { return bricks.size() * sizeof(Brick); }
+    bool empty() const { return voxelCount == 0; }
+
+    // Inclusive bounding box of all occupied voxels, false when empty
+    bool getBounds(uint32_t& outMinX, uint32_t& outMinY, uint32_t& outMinZ,
+                   uint32_t& outMaxX, uint32_t& outMaxY, uint32_t& outMaxZ) const {
+        if (voxelCount == 0) return false;
+        outMinX = minX; outMinY = minY; outMinZ = minZ;
+        outMaxX = maxX; outMaxY = maxY; outMaxZ = maxZ;
+        return true;
+    }
+
+private:
+    static int countTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    uint64_t chunkMask[8] = {};           // bit per chunk, see chunkIndex()
+    std::array<int16_t, 512> brickIndex;  // index into bricks, -1 for empty chunks
+    std::vector<Brick> bricks;
+    size_t voxelCount = 0;
+    uint8_t minX = 0, minY = 0, minZ = 0, maxX = 0, maxY = 0, maxZ = 0;
+};
+
 // Create a structure to represent a model with its voxels with helper functions
+// Voxels are stored CSR style: one contiguous array of packed positions grouped by
+// material/color bucket, plus the sorted list of used bucket keys and their offsets
+// Decode appends with addVoxel(), finalize() then groups the voxels into buckets
 struct VmaxModel {
+    // Every possible bucket key, 8 materials x 256 colors
+    static constexpr uint32_t kBucketCount = 8 * 256;
+
     // Model identifier or name
     std::string vmaxbFileName; // file name is used like a key
     
-    // Voxels organized by material and color
-    // First dimension: material (0-7)
-    // Second dimension: color (1-255, index 0 unused since color 0 means no voxel)
-    std::vector<VmaxVoxel> voxels[8][256];
+    // Packed positions of every voxel, bucket after bucket in ascending key order
+    std::vector<uint32_t> positions;
+    // Keys of non empty buckets in ascending order, see vmaxBucketKey()
+    std::vector<uint16_t> bucketKeys;
+    // positions[bucketOffsets[i] .. bucketOffsets[i+1]) belong to bucketKeys[i]
+    std::vector<uint32_t> bucketOffsets;
+    
+    // Which voxels of the 256x256x256 volume are filled, any material and color
+    // Filled by addVoxel() so it is ready as soon as decode is done
+    VmaxOccupancy occupancy;
     
     // Each model has local 0-7 materials
     std::array<VmaxMaterial, 8> materials;
@@ -243,10 +862,113 @@ struct VmaxModel {
     VmaxModel(const std::string& modelName) : vmaxbFileName(modelName) {
     }
     
-    // Add a voxel to this model
-    void addVoxel(int x, int y, int z, int material, int color, int chunk, int chunkMin) {
+    // Add a voxel to this model, position is in 256x256x256 model space
+    // Voxels are staged until finalize() is called, occupancy is updated right away
+    void addVoxel(int x, int y, int z, int material, int color) {
         if (material >= 0 && material < 8 && color > 0 && color < 256) {
-            voxels[material][color].emplace_back(x, y, z, material, color, chunk, chunkMin);
+            stagedPositions.push_back(packVoxelPosition(x, y, z));
+            stagedKeys.push_back(vmaxBucketKey(material, color));
+            occupancy.set(x, y, z);
+        }
+    }
+
+    // O(1) point lookup, see VmaxOccupancy
+    bool hasVoxel(int x, int y, int z) const {
+        return occupancy.test(x, y, z);
+    }
+
+    // Group staged voxels into their buckets with a counting sort
+    // Order of voxels within a bucket is the order they were added
+    // Safe to call again after adding more voxels
+    void finalize() {
+        if (stagedPositions.empty()) return;
+        // Put existing buckets back in front of the staged voxels
+        if (!positions.empty()) {
+            std::vector<uint32_t> restagedPositions;
+            std::vector<uint16_t> restagedKeys;
+            restagedPositions.reserve(positions.size() + stagedPositions.size());
+            restagedKeys.reserve(positions.size() + stagedPositions.size());
+            for (size_t b = 0; b < bucketKeys.size(); b++) {
+                for (uint32_t i = bucketOffsets[b]; i < bucketOffsets[b + 1]; i++) {
+                    restagedPositions.push_back(positions[i]);
+                    restagedKeys.push_back(bucketKeys[b]);
+                }
+            }
+            restagedPositions.insert(restagedPositions.end(), stagedPositions.begin(), stagedPositions.end());
+            restagedKeys.insert(restagedKeys.end(), stagedKeys.begin(), stagedKeys.end());
+            stagedPositions.swap(restagedPositions);
+            stagedKeys.swap(restagedKeys);
+        }
+
+        std::array<uint32_t, kBucketCount> counts{}; // 8KB each, fine on a worker stack
+        for (uint16_t key : stagedKeys) counts[key]++;
+
+        bucketKeys.clear();
+        bucketOffsets.clear();
+        std::array<uint32_t, kBucketCount> cursor{};
+        uint32_t offset = 0;
+        for (uint32_t key = 0; key < kBucketCount; key++) {
+            if (counts[key] == 0) continue;
+            bucketKeys.push_back(static_cast<uint16_t>(key));
+            bucketOffsets.push_back(offset);
+            cursor[key] = offset;
+            offset += counts[key];
+        }
+        bucketOffsets.push_back(offset);
+
+        positions.assign(offset, 0);
+        for (size_t i = 0; i < stagedKeys.size(); i++) {
+            positions[cursor[stagedKeys[i]]++] = stagedPositions[i];
+        }
+        std::vector<uint32_t>().swap(stagedPositions); // release staging memory
+        std::vector<uint16_t>().swap(stagedKeys);
+    }
+
+    // Move every voxel of bucket key k to bucket keyMap[k], buckets that end up with the same key are merged
+    // Merged buckets keep their voxels in the order of the old keys, occupancy does not change
+    void remapBucketKeys(const std::array<uint16_t, kBucketCount>& keyMap) {
+        finalize();
+        std::array<uint32_t, kBucketCount> counts{};
+        for (size_t b = 0; b < bucketKeys.size(); b++) {
+            counts[keyMap[bucketKeys[b]]] += bucketOffsets[b + 1] - bucketOffsets[b];
+        }
+        std::vector<uint16_t> newKeys;
+        std::vector<uint32_t> newOffsets;
+        std::array<uint32_t, kBucketCount> cursor{};
+        uint32_t offset = 0;
+        for (uint32_t key = 0; key < kBucketCount; key++) {
+            if (counts[key] == 0) continue;
+            newKeys.push_back(static_cast<uint16_t>(key));
+            newOffsets.push_back(offset);
+            cursor[key] = offset;
+            offset += counts[key];
+        }
+        newOffsets.push_back(offset);
+        std::vector<uint32_t> newPositions(positions.size());
+        for (size_t b = 0; b < bucketKeys.size(); b++) {
+            uint32_t count = bucketOffsets[b + 1] - bucketOffsets[b];
+            if (count) std::memcpy(newPositions.data() + cursor[keyMap[bucketKeys[b]]], positions.data() + bucketOffsets[b], count * sizeof(uint32_t));
+            cursor[keyMap[bucketKeys[b]]] += count;
+        }
+        positions.swap(newPositions);
+        bucketKeys.swap(newKeys);
+        bucketOffsets.swap(newOffsets);
+    }
+
+    // Replace all voxels with already bucketed arrays, as written by finalize()
+    // Used to load a cached model, occupancy is rebuilt from the positions
+    void assignBuckets(const uint32_t* newPositions, size_t positionCount,
+                       const uint16_t* newKeys, const uint32_t* newOffsets, size_t bucketCount) {
+        positions.assign(newPositions, newPositions + positionCount);
+        bucketKeys.assign(newKeys, newKeys + bucketCount);
+        bucketOffsets.assign(newOffsets, newOffsets + bucketCount + 1);
+        std::vector<uint32_t>().swap(stagedPositions);
+        std::vector<uint16_t>().swap(stagedKeys);
+        occupancy = VmaxOccupancy();
+        for (uint32_t packed : positions) {
+            uint32_t x, y, z;
+            unpackVoxelPosition(packed, x, y, z);
+            occupancy.set(x, y, z);
         }
     }
 
@@ -260,42 +982,335 @@ struct VmaxModel {
         colors = newColors;
     }
      
-    // Get all voxels of a specific material and color
-    const std::vector<VmaxVoxel>& getVoxels(int material, int color) const {
+    // Index of a material/color bucket in bucketKeys, -1 when the model has no such voxels
+    int findBucket(int material, int color) const {
         if (material >= 0 && material < 8 && color > 0 && color < 256) {
-            return voxels[material][color];
+            uint16_t key = vmaxBucketKey(material, color);
+            auto found = std::lower_bound(bucketKeys.begin(), bucketKeys.end(), key);
+            if (found != bucketKeys.end() && *found == key) {
+                return static_cast<int>(found - bucketKeys.begin());
+            }
         }
-        static std::vector<VmaxVoxel> empty;
-        return empty;
+        return -1;
+    }
+
+    // Get all voxels of a specific material and color, as packed positions
+    VmaxVoxelSpan getVoxels(int material, int color) const {
+        int b = findBucket(material, color);
+        if (b < 0) return VmaxVoxelSpan{};
+        return VmaxVoxelSpan{positions.data() + bucketOffsets[b], positions.data() + bucketOffsets[b + 1]};
     }
     
     // Get total voxel count for this model
+    // Like findBucket() and getVoxels() only finalized voxels count, call finalize() first
     size_t getTotalVoxelCount() const {
-        size_t count = 0;
-        for (int m = 0; m < 8; m++) {
-            for (int c = 1; c < 256; c++) {  // Skip index 0
-                count += voxels[m][c].size();
-            }
-        }
-        return count;
+        return positions.size();
     }
 
-    // Get a map of used materials and their associated colors
+    // Get a map of used materials and their associated colors, finalized buckets only
     std::map<int, std::set<int>> getUsedMaterialsAndColors() const {
         std::map<int, std::set<int>> result;
-        
-        // Iterate through fixed size arrays - we know it's 8 materials and 256 colors
-        for (int material = 0; material < 8; material++) {
-            for (int color = 1; color < 256; color++) {  // Skip index 0 as it means no voxel
-                if (!voxels[material][color].empty()) {
-                    result[material].insert(color);
+        for (uint16_t key : bucketKeys) {
+            result[key >> 8].insert(key & 0xff);
+        }
+        return result;
+    }
+
+private:
+    // Voxels added since the last finalize(), parallel arrays
+    std::vector<uint32_t> stagedPositions;
+    std::vector<uint16_t> stagedKeys;
+};
+
+// Does a voxel block the view of its neighbours
+// Mirrors addModelToScene: material 7 is liquid, material 6 and alpha < 255 colors are glass
+// @param material: material 0-7
+// @param color: palette color of the voxel
+inline bool vmaxVoxelIsOpaque(int material, const VmaxRGBA& color) {
+    return material != 6 && material != 7 && color.a == 255;
+}
+
+// Occupancy of only the opaque voxels of a model, used to find voxels that can never be seen
+// @param model: decoded and finalized model
+// @param palette: the model's palette, voxel color c uses palette[c-1]
+inline VmaxOccupancy buildOpaqueOccupancy(const VmaxModel& model, const std::vector<VmaxRGBA>& palette) {
+    VmaxOccupancy opaque;
+    for (size_t b = 0; b < model.bucketKeys.size(); b++) {
+        int material = model.bucketKeys[b] >> 8;
+        int color = model.bucketKeys[b] & 0xff;
+        if (color - 1 >= static_cast<int>(palette.size())) continue;
+        if (!vmaxVoxelIsOpaque(material, palette[color - 1])) continue;
+        for (uint32_t i = model.bucketOffsets[b]; i < model.bucketOffsets[b + 1]; i++) {
+            uint32_t x, y, z;
+            unpackVoxelPosition(model.positions[i], x, y, z);
+            opaque.set(x, y, z);
+        }
+    }
+    return opaque;
+}
+
+// CIELAB of a palette color, L 0-100, from the linear sRGB primaries with a D65 white
+inline std::array<float, 3> vmaxColorToLab(const VmaxRGBA& color) {
+    float r = srgbToLinear(color.r / 255.0f);
+    float g = srgbToLinear(color.g / 255.0f);
+    float b = srgbToLinear(color.b / 255.0f);
+    float xyz[3] = {
+        (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f,
+        0.2126f * r + 0.7152f * g + 0.0722f * b,
+        (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f
+    };
+    for (float& v : xyz) v = v > 0.008856f ? std::cbrt(v) : 7.787f * v + 16.0f / 116.0f;
+    return {116.0f * xyz[1] - 16.0f, 500.0f * (xyz[0] - xyz[1]), 200.0f * (xyz[1] - xyz[2])};
+}
+
+// Bucket key map for --merge-colors, see VmaxModel::remapBucketKeys()
+// Colors are clustered per material, the most used colors become cluster centers and every other
+// color joins the closest center within deltaE (CIE76), or starts a cluster of its own
+// Only colors with the same alpha merge so glass and opaque voxels never end up in one bucket
+// @param model: decoded and finalized model
+// @param palette: the model's palette, voxel color c uses palette[c-1]
+// @param deltaE: largest distance merged, 1 is about a just noticeable difference
+// @return new key of every bucket key, unused and unmerged keys map to themselves
+inline std::array<uint16_t, VmaxModel::kBucketCount> vmaxMergeColorsKeyMap(const VmaxModel& model, const std::vector<VmaxRGBA>& palette, float deltaE) {
+    std::array<uint16_t, VmaxModel::kBucketCount> keyMap;
+    for (uint32_t key = 0; key < VmaxModel::kBucketCount; key++) keyMap[key] = static_cast<uint16_t>(key);
+
+    // Buckets by material, largest first, equal sizes in key order
+    std::vector<size_t> order(model.bucketKeys.size());
+    for (size_t b = 0; b < order.size(); b++) order[b] = b;
+    auto bucketSize = [&](size_t b) { return model.bucketOffsets[b + 1] - model.bucketOffsets[b]; };
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        int materialA = model.bucketKeys[a] >> 8, materialB = model.bucketKeys[b] >> 8;
+        if (materialA != materialB) return materialA < materialB;
+        return bucketSize(a) > bucketSize(b);
+    });
+
+    float maxDistance2 = deltaE * deltaE;
+    struct Center { uint16_t key; uint8_t alpha; std::array<float, 3> lab; };
+    std::vector<Center> centers; // of the material being clustered
+    int material = -1;
+    for (size_t b : order) {
+        uint16_t key = model.bucketKeys[b];
+        int color = key & 0xff;
+        if (color - 1 >= static_cast<int>(palette.size())) continue;
+        if ((key >> 8) != material) {
+            material = key >> 8;
+            centers.clear();
+        }
+        const VmaxRGBA& rgba = palette[color - 1];
+        std::array<float, 3> lab = vmaxColorToLab(rgba);
+        const Center* closest = nullptr;
+        float closestDistance2 = maxDistance2;
+        for (const Center& center : centers) {
+            if (center.alpha != rgba.a) continue;
+            float dl = lab[0] - center.lab[0], da = lab[1] - center.lab[1], db = lab[2] - center.lab[2];
+            float distance2 = dl * dl + da * da + db * db;
+            if (distance2 <= closestDistance2) {
+                closest = &center;
+                closestDistance2 = distance2;
+            }
+        }
+        if (closest) {
+            keyMap[key] = closest->key;
+        } else {
+            centers.push_back(Center{key, rgba.a, lab});
+        }
+    }
+    return keyMap;
+}
+
+// A voxel is hidden when all six face neighbours are opaque
+// Voxels on the border of the 256x256x256 volume are always visible
+inline bool vmaxVoxelIsHidden(const VmaxOccupancy& opaque, int x, int y, int z) {
+    return opaque.test(x - 1, y, z) && opaque.test(x + 1, y, z) &&
+           opaque.test(x, y - 1, z) && opaque.test(x, y + 1, z) &&
+           opaque.test(x, y, z - 1) && opaque.test(x, y, z + 1);
+}
+
+// One level down the LOD pyramid, every 2x2x2 cell of the model becomes one voxel
+// A cell is filled when any of its voxels is, with the material and color most of them share,
+// ties go to the lower bucket key. The result is in half resolution model space (0-127 for a full model)
+// Single pass over the occupied chunks of the occupancy bricks, material/color comes from a
+// dense key table of the occupied chunks only
+// @param model: decoded and finalized model
+// @return finalized model with the same name, materials and colors
+inline VmaxModel downsampleVmaxModel(const VmaxModel& model) {
+    constexpr int kChunkVoxels = 32 * 32 * 32;
+    VmaxModel coarse(model.vmaxbFileName);
+    coarse.materials = model.materials;
+    coarse.colors = model.colors;
+
+    // Bucket key of every voxel of the occupied chunks, 0 is empty
+    // Up to 32MB for a full model, taken from the thread arena instead of the heap
+    VmaxArena& arena = vmaxThreadArena();
+    VmaxArenaScope arenaScope(arena);
+    std::array<int16_t, 512> chunkSlot;
+    chunkSlot.fill(-1);
+    int16_t slotCount = 0;
+    model.occupancy.forEachOccupiedChunk([&](int cx, int cy, int cz, const VmaxOccupancy::Brick&) {
+        chunkSlot[VmaxOccupancy::chunkIndex(cx, cy, cz)] = slotCount++;
+    });
+    VmaxArenaVector<uint16_t> keys(size_t(slotCount) * kChunkVoxels, 0, VmaxArenaAllocator<uint16_t>(arena));
+    for (size_t b = 0; b < model.bucketKeys.size(); b++) {
+        for (uint32_t i = model.bucketOffsets[b]; i < model.bucketOffsets[b + 1]; i++) {
+            uint32_t x, y, z;
+            unpackVoxelPosition(model.positions[i], x, y, z);
+            int16_t slot = chunkSlot[VmaxOccupancy::chunkIndex(x >> 5, y >> 5, z >> 5)];
+            keys[size_t(slot) * kChunkVoxels + (x & 31) + (y & 31) * 32 + (z & 31) * 1024] = model.bucketKeys[b];
+        }
+    }
+
+    model.occupancy.forEachOccupiedChunk([&](int cx, int cy, int cz, const VmaxOccupancy::Brick& brick) {
+        const uint16_t* chunkKeys = keys.data() + size_t(chunkSlot[VmaxOccupancy::chunkIndex(cx, cy, cz)]) * kChunkVoxels;
+        for (int z = 0; z < 32; z += 2) {
+            for (int y = 0; y < 32; y += 2) {
+                uint32_t rows = brick[y + z * 32] | brick[y + 1 + z * 32] | brick[y + (z + 1) * 32] | brick[y + 1 + (z + 1) * 32];
+                uint32_t cells = (rows | (rows >> 1)) & 0x55555555; // bit 2i set when cell i has a voxel
+                while (cells) {
+#if defined(_MSC_VER)
+                    unsigned long bit;
+                    _BitScanForward(&bit, cells);
+                    int x = static_cast<int>(bit);
+#else
+                    int x = __builtin_ctz(cells);
+#endif
+                    cells &= cells - 1;
+                    // Up to 8 votes, counted in place
+                    uint16_t votes[8];
+                    int voteCount = 0;
+                    for (int dz = 0; dz < 2; dz++) {
+                        for (int dy = 0; dy < 2; dy++) {
+                            for (int dx = 0; dx < 2; dx++) {
+                                uint16_t key = chunkKeys[(x + dx) + (y + dy) * 32 + (z + dz) * 1024];
+                                if (key) votes[voteCount++] = key;
+                            }
+                        }
+                    }
+                    uint16_t best = 0;
+                    int bestCount = 0;
+                    for (int i = 0; i < voteCount; i++) {
+                        int count = 0;
+                        for (int j = 0; j < voteCount; j++) count += votes[j] == votes[i] ? 1 : 0;
+                        if (count > bestCount || (count == bestCount && votes[i] < best)) {
+                            best = votes[i];
+                            bestCount = count;
+                        }
+                    }
+                    if (bestCount == 0) continue;
+                    coarse.addVoxel((cx * 32 + x) >> 1, (cy * 32 + y) >> 1, (cz * 32 + z) >> 1, best >> 8, best & 0xff);
                 }
             }
         }
-        return result;
+    });
+    coarse.finalize();
+    return coarse;
+}
+
+// Model downsampled levels times (at least once), see downsampleVmaxModel()
+// A voxel at x,y,z of the result covers the 2^levels cube starting at x,y,z * 2^levels of the model
+inline VmaxModel buildVmaxLod(const VmaxModel& model, int levels) {
+    VmaxModel lod = downsampleVmaxModel(model);
+    for (int level = 1; level < levels; level++) {
+        lod = downsampleVmaxModel(lod);
     }
+    return lod;
+}
+
+// One merged rectangle of coplanar voxel faces, output of buildGreedyQuads()
+// Face of the voxels at axis coordinate slice, facing +axis or -axis
+// The rectangle covers u0..u0+w-1 and v0..v0+h-1 where u = (axis+1)%3 and v = (axis+2)%3
+struct VmaxQuad {
+    uint8_t axis;     // 0 x, 1 y, 2 z
+    bool positive;    // normal points along +axis
+    uint8_t slice;    // voxel coordinate along axis
+    uint8_t u0, v0;
+    uint16_t w, h;    // size in voxels, 1-256
 };
 
+/**
+ * Greedy mesh the visible faces of one material/color bucket
+ * A face is visible when the neighbouring cell is neither opaque nor part of the same bucket
+ * Faces are gathered per voxel, sorted by plane and row, merged into runs along u
+ * and runs with the same extent on consecutive rows are merged along v
+ * 
+ * @param model decoded and finalized model
+ * @param bucket index into model.bucketKeys
+ * @param opaque occupancy of the model's opaque voxels, see buildOpaqueOccupancy()
+ * @param quads receives the merged rectangles, cleared first
+ */
+inline void buildGreedyQuads(const VmaxModel& model, size_t bucket, const VmaxOccupancy& opaque, std::vector<VmaxQuad>& quads) {
+    quads.clear();
+    uint32_t first = model.bucketOffsets[bucket];
+    uint32_t last = model.bucketOffsets[bucket + 1];
+
+    // Transparent buckets do not show up in the opaque occupancy, they need their own
+    // so faces between two voxels of the same bucket are dropped
+    VmaxOccupancy bucketOccupancy;
+    for (uint32_t i = first; i < last; i++) {
+        uint32_t x, y, z;
+        unpackVoxelPosition(model.positions[i], x, y, z);
+        bucketOccupancy.set(x, y, z);
+    }
+
+    // Face key: direction << 24 | slice << 16 | v << 8 | u, sorting groups faces by plane then row
+    std::vector<uint32_t> faces;
+    for (uint32_t i = first; i < last; i++) {
+        uint32_t p[3];
+        unpackVoxelPosition(model.positions[i], p[0], p[1], p[2]);
+        for (uint32_t direction = 0; direction < 6; direction++) {
+            uint32_t axis = direction >> 1;
+            int step = (direction & 1) ? 1 : -1;
+            int n[3] = { static_cast<int>(p[0]), static_cast<int>(p[1]), static_cast<int>(p[2]) };
+            n[axis] += step;
+            if (opaque.test(n[0], n[1], n[2]) || bucketOccupancy.test(n[0], n[1], n[2])) continue;
+            uint32_t u = p[(axis + 1) % 3];
+            uint32_t v = p[(axis + 2) % 3];
+            faces.push_back((direction << 24) | (p[axis] << 16) | (v << 8) | u);
+        }
+    }
+    std::sort(faces.begin(), faces.end());
+
+    // Merge a plane (same direction and slice) at a time
+    std::vector<VmaxQuad> open, rowRuns, stillOpen;
+    size_t f = 0;
+    while (f < faces.size()) {
+        uint32_t plane = faces[f] >> 16;
+        uint8_t axis = static_cast<uint8_t>((plane >> 8) >> 1);
+        bool positive = ((plane >> 8) & 1) != 0;
+        uint8_t slice = static_cast<uint8_t>(plane & 0xff);
+        open.clear();
+        while (f < faces.size() && (faces[f] >> 16) == plane) {
+            uint32_t v = (faces[f] >> 8) & 0xff;
+            // Runs of consecutive u on row v
+            rowRuns.clear();
+            while (f < faces.size() && (faces[f] >> 8) == ((plane << 8) | v)) {
+                uint32_t u = faces[f] & 0xff;
+                if (!rowRuns.empty() && rowRuns.back().u0 + rowRuns.back().w == u) {
+                    rowRuns.back().w++;
+                } else {
+                    rowRuns.push_back(VmaxQuad{axis, positive, slice, static_cast<uint8_t>(u), static_cast<uint8_t>(v), 1, 1});
+                }
+                f++;
+            }
+            // Extend open quads that ended on the previous row with an identical run, both lists are sorted by u0
+            stillOpen.clear();
+            size_t o = 0;
+            for (VmaxQuad& run : rowRuns) {
+                while (o < open.size() && open[o].u0 < run.u0) quads.push_back(open[o++]);
+                if (o < open.size() && open[o].u0 == run.u0 && open[o].w == run.w && open[o].v0 + open[o].h == v) {
+                    open[o].h++;
+                    stillOpen.push_back(open[o++]);
+                } else {
+                    stillOpen.push_back(run);
+                }
+            }
+            while (o < open.size()) quads.push_back(open[o++]);
+            open.swap(stillOpen);
+        }
+        quads.insert(quads.end(), open.begin(), open.end());
+    }
+}
+
 inline std::array<VmaxMaterial, 8> getVmaxMaterials(plist_t pnodPalettePlist) {
     // Directly access the materials array
     std::array<VmaxMaterial, 8> vmaxMaterials;
@@ -364,6 +1379,68 @@ inline std::array<VmaxMaterial, 8> getVmaxMaterials(plist_t pnodPalettePlist) {
 }
 
 
+/**
+ * Walks a ds data stream in place and visits every non empty voxel
+ * No copies of the stream and no intermediate voxel lists, the chunk offset is applied inline
+ * 
+ * @param dsData The raw ds bytes, borrowed from the plist, pairs of [material, color+1]
+ * @param dsLength Length of dsData in bytes
+ * @param chunkID 8x8x8 chunk morton code, each chunk is 32x32x32 voxels of the 256x256x256 model
+ * @param mortonOffset morton code of the first pair within the 32x32x32 chunk
+ * @param visit called as visit(x, y, z, material, color) for each voxel with color != 0, x y z in model space
+ */
+template <typename Visitor>
+inline void forEachDsVoxel(const uint8_t* dsData, size_t dsLength, uint64_t chunkID, uint64_t mortonOffset, Visitor&& visit) {
+    uint32_t model_8x8x8_x, model_8x8x8_y, model_8x8x8_z;
+    decodeMorton3DOptimized(static_cast<uint32_t>(chunkID), 
+                            model_8x8x8_x, 
+                            model_8x8x8_y, 
+                            model_8x8x8_z); // index IS the morton code
+    uint32_t model_256x256x256_x = model_8x8x8_x * 32; // convert to model space
+    uint32_t model_256x256x256_y = model_8x8x8_y * 32;
+    uint32_t model_256x256x256_z = model_8x8x8_z * 32;
+
+    // pairs sit at consecutive morton codes so positions are decoded a block at a time
+    constexpr size_t blockSize = 256;
+    uint8_t blockX[blockSize], blockY[blockSize], blockZ[blockSize];
+    size_t pairCount = dsLength / 2;
+    for (size_t blockStart = 0; blockStart < pairCount; blockStart += blockSize) {
+        size_t blockCount = std::min(blockSize, pairCount - blockStart);
+        decodeMorton3DBatch(static_cast<uint32_t>(blockStart + mortonOffset), blockCount, blockX, blockY, blockZ);
+        const uint8_t* pair = dsData + blockStart * 2;
+        for (size_t i = 0; i < blockCount; i++, pair += 2) {
+            uint8_t material = pair[0]; // also known as a layer color
+            uint8_t color = pair[1];
+            if (color == 0) continue; // 0 means no voxel
+            visit(model_256x256x256_x + blockX[i],
+                  model_256x256x256_y + blockY[i],
+                  model_256x256x256_z + blockZ[i],
+                  material,
+                  color);
+        }
+    }
+}
+
+/**
+ * Decodes a snapshot's ds data stream straight into a model's final storage
+ * 
+ * @param dsData The raw ds bytes, borrowed from the plist
+ * @param dsLength Length of dsData in bytes
+ * @param chunkID chunk ID
+ * @param mortonOffset offset to apply to the morton code
+ * @param model model receiving the voxels
+ * @return number of voxels added
+ */
+inline size_t decodeVoxelsInto(const uint8_t* dsData, size_t dsLength, uint64_t chunkID, uint64_t mortonOffset, VmaxModel& model) {
+    size_t added = 0;
+    forEachDsVoxel(dsData, dsLength, chunkID, mortonOffset,
+        [&](uint32_t x, uint32_t y, uint32_t z, uint8_t material, uint8_t color) {
+            model.addVoxel(x, y, z, material, color);
+            added++;
+        });
+    return added;
+}
+
 /**
  * Decodes a voxel's material index and palette index from the ds data stream
  * 
@@ -374,29 +1451,11 @@ inline std::array<VmaxMaterial, 8> getVmaxMaterials(plist_t pnodPalettePlist) {
  */
 inline std::vector<VmaxVoxel> decodeVoxels(const std::vector<uint8_t>& dsData, int mortonOffset, uint16_t chunkID) {
     std::vector<VmaxVoxel> voxels;
-    uint8_t material;
-    uint8_t color;
-    for (int i = 0; i < dsData.size() - 1; i += 2) {
-        material = dsData[i]; // also known as a layer color
-        color = dsData[i + 1];
-        uint32_t _tempx, _tempy, _tempz;
-        decodeMorton3DOptimized(i/2 + mortonOffset,
-                                _tempx,
-                                _tempy,
-                                _tempz); // index IS the morton code
-        if (color != 0) {
-            VmaxVoxel voxel = {
-                static_cast<uint8_t>(_tempx), 
-                static_cast<uint8_t>(_tempy), 
-                static_cast<uint8_t>(_tempz), 
-                material,
-                color,
-                chunkID, // todo is wasteful to pass chunkID?
-                static_cast<uint16_t>(mortonOffset)
-            };
-            voxels.push_back(voxel);
-        }
-    }
+    // chunk ID 0 keeps the voxels in chunk local space
+    forEachDsVoxel(dsData.data(), dsData.size(), 0, mortonOffset,
+        [&](uint32_t x, uint32_t y, uint32_t z, uint8_t material, uint8_t color) {
+            voxels.emplace_back(x, y, z, material, color, chunkID, static_cast<uint16_t>(mortonOffset));
+        });
     return voxels;
 }
 
@@ -468,61 +1527,493 @@ VmaxChunkInfo vmaxChunkInfo(const plist_t& plist_snapshot_dict_item) {
     return VmaxChunkInfo{-1, 0, 0, 0, 0, 0};
 }
 
+// Borrow the bytes of a plist data node without copying them
+// The pointer stays valid for as long as the plist is alive
+// @param plist_datastream: plist_t of s.ds
+// @param length: set to the number of bytes
+// @return pointer into the plist, nullptr if the node is missing
+inline const uint8_t* borrowPlistData(plist_t plist_datastream, uint64_t& length) {
+    length = 0;
+    if (!plist_datastream || plist_get_node_type(plist_datastream) != PLIST_DATA) return nullptr;
+    return reinterpret_cast<const uint8_t*>(plist_get_data_ptr(plist_datastream, &length));
+}
 
 // Right after we get VmaxChunkInfo, we can get the voxels because we need morton chunk offset
+// Prefer decodeVoxelsInto when the voxels end up in a VmaxModel anyway
 // @param pnodSnaphot: plist_t of a snapshot
-// @return vector of VmaxVoxel
+// @return vector of VmaxVoxel, positions in 256x256x256 model space
 //std::vector<VmaxVoxel> getVmaxSnapshot(plist_t& pnod_each_snapshot) {
 std::vector<VmaxVoxel> vmaxVoxelInfo(plist_t& plist_datastream, uint64_t chunkID, uint64_t minMorton) {
     std::vector<VmaxVoxel> voxelsArray; 
-    try {
+    uint64_t length = 0;
+    const uint8_t* data = borrowPlistData(plist_datastream, length);
+    forEachDsVoxel(data, length, chunkID, minMorton,
+        [&](uint32_t x, uint32_t y, uint32_t z, uint8_t material, uint8_t color) {
+            voxelsArray.emplace_back(x, y, z, material, color, 
+                                     static_cast<uint16_t>(chunkID), 
+                                     static_cast<uint16_t>(minMorton));
+        });
+    return voxelsArray;
+}
 
-        // Extract the binary data
-        char* data = nullptr;
-        uint64_t length = 0;
-        plist_get_data_val(plist_datastream, &data, &length);
-        auto foo =  std::vector<uint8_t>(data, data + length) ;
-        std::vector<VmaxVoxel> allModelVoxels = decodeVoxels(std::vector<uint8_t>(data, data + length), minMorton, chunkID);
-
-
-        uint32_t model_8x8x8_x, model_8x8x8_y, model_8x8x8_z;
-        decodeMorton3DOptimized(chunkID, 
-                                model_8x8x8_x, 
-                                model_8x8x8_y, 
-                                model_8x8x8_z); // index IS the morton code
-        int model_256x256x256_x = model_8x8x8_x * 8; // convert to model space
-        int model_256x256x256_y = model_8x8x8_y * 8;
-        int model_256x256x256_z = model_8x8x8_z * 8;
-
-        for (const VmaxVoxel& eachVmaxVoxel : allModelVoxels) {
-            auto [  chunk_32x32x32_x, 
-                    chunk_32x32x32_y, 
-                    chunk_32x32x32_z, 
-                    materialMap, 
-                    colorMap, 
-                    chunkID, 
-                    minMorton] = eachVmaxVoxel;
-
-            int voxel_256x256x256_x = model_256x256x256_x + chunk_32x32x32_x;
-            int voxel_256x256x256_y = model_256x256x256_y + chunk_32x32x32_y;
-            int voxel_256x256x256_z = model_256x256x256_z + chunk_32x32x32_z;
-
-            auto one_voxel = VmaxVoxel(voxel_256x256x256_x, 
-                                    voxel_256x256x256_y, 
-                                    voxel_256x256x256_z, 
-                                    materialMap, 
-                                    colorMap,
-                                    chunkID,
-                                    minMorton);
-            voxelsArray.push_back(one_voxel);
-        }
-        return voxelsArray;
-    } catch (std::exception& e) {
-        std::cout << "Error: " << e.what() << std::endl;    
-        // Just continue to next snapshot
-        // This bypass might mean we miss useful snapshots
+// Read only memory map of a whole file, falls back to reading it into memory
+// if mapping is not possible. Unmapped when destroyed
+class VmaxMappedFile {
+public:
+    explicit VmaxMappedFile(const std::string& fileName) {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER fileSize;
+            if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+                HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping) {
+                    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(mapping); // the view keeps the mapping alive
+                    if (view) {
+                        mapped = static_cast<const uint8_t*>(view);
+                        mappedSize = static_cast<size_t>(fileSize.QuadPart);
+                    }
+                }
+            }
+            CloseHandle(file);
+            opened = true;
+        }
+#else
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat fileStat;
+            if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+                void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (view != MAP_FAILED) {
+                    mapped = static_cast<const uint8_t*>(view);
+                    mappedSize = static_cast<size_t>(fileStat.st_size);
+                }
+            }
+            close(fd);
+            opened = true;
+        }
+#endif
+        if (opened && !mapped) { // empty file or mapping failed, read it the old way
+            std::ifstream rawBytesFile(fileName, std::ios::binary);
+            opened = rawBytesFile.is_open();
+            if (opened) {
+                fallback.assign(std::istreambuf_iterator<char>(rawBytesFile), std::istreambuf_iterator<char>());
+            }
+        }
+    }
+
+    ~VmaxMappedFile() {
+        if (!mapped) return;
+#if defined(_WIN32)
+        UnmapViewOfFile(mapped);
+#else
+        munmap(const_cast<uint8_t*>(mapped), mappedSize);
+#endif
+    }
+
+    VmaxMappedFile(const VmaxMappedFile&) = delete;
+    VmaxMappedFile& operator=(const VmaxMappedFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    const uint8_t* data() const { return mapped ? mapped : fallback.data(); }
+    size_t size() const { return mapped ? mappedSize : fallback.size(); }
+
+private:
+    bool opened = false;
+    const uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+    std::vector<uint8_t> fallback;
+};
+
+// Central directory of a .zip, read straight from a memory map of the archive
+// Entries are stored (method 0) or deflated (method 8), deflate is undone with stb_image's zlib decoder
+// Deflated entries are inflated once, on first use, and kept until the archive is destroyed
+// Zip64 archives are handled, encrypted entries and multi disk archives are not
+// Names are relative to the directory holding scene.json, so foo.zip/foo.vmax/scene.json reads as scene.json
+class VmaxZipArchive {
+public:
+    struct Entry {
+        std::string name;
+        uint64_t localOffset = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        uint16_t method = 0;
+    };
+
+    explicit VmaxZipArchive(const std::string& zipFileName) : file(zipFileName) {
+        opened = file.isOpen() && readCentralDirectory();
+        once.reset(new std::once_flag[entries.size()]);
+        inflated.resize(entries.size());
+    }
+
+    VmaxZipArchive(const VmaxZipArchive&) = delete;
+    VmaxZipArchive& operator=(const VmaxZipArchive&) = delete;
+
+    bool isOpen() const { return opened; }
+    const std::vector<Entry>& list() const { return entries; }
+
+    // @return index of an entry relative to the scene.json directory, -1 if there is none
+    int find(const std::string& relativeName) const {
+        auto found = byName.find(relativeName);
+        return found == byName.end() ? -1 : found->second;
+    }
+
+    // Bytes of an entry, stored entries point into the map, deflated ones into the inflated copy
+    // Safe to call from several threads
+    // @return false if the entry is malformed or does not inflate to its recorded size
+    bool read(int index, const uint8_t*& outData, size_t& outSize) {
+        if (index < 0 || static_cast<size_t>(index) >= entries.size()) return false;
+        const uint8_t* stored = nullptr;
+        const Entry& entry = entries[index];
+        if (!entryData(entry, stored)) return false;
+        if (entry.method == 0) {
+            outData = stored;
+            outSize = static_cast<size_t>(entry.uncompressedSize);
+            return true;
+        }
+        std::call_once(once[index], [&]() {
+            if (entry.compressedSize > INT32_MAX || entry.uncompressedSize > INT32_MAX) return;
+            std::vector<uint8_t> bytes(static_cast<size_t>(entry.uncompressedSize));
+            int decoded = bytes.empty() ? 0 : stbi_zlib_decode_noheader_buffer(
+                reinterpret_cast<char*>(bytes.data()), static_cast<int>(bytes.size()),
+                reinterpret_cast<const char*>(stored), static_cast<int>(entry.compressedSize));
+            if (decoded >= 0 && static_cast<size_t>(decoded) == bytes.size()) {
+                inflated[index] = std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+            }
+        });
+        if (!inflated[index]) return false;
+        outData = inflated[index]->data();
+        outSize = inflated[index]->size();
+        return true;
     }
-    return voxelsArray; // empty return
+
+private:
+    static uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    static uint32_t le32(const uint8_t* p) { return le16(p) | (static_cast<uint32_t>(le16(p + 2)) << 16); }
+    static uint64_t le64(const uint8_t* p) { return le32(p) | (static_cast<uint64_t>(le32(p + 4)) << 32); }
+
+    // End of central directory record: signature, disk numbers, entry counts, size, offset, comment
+    // Zip64: a locator just before it points at a 64 bit copy, 0xFFFF... fields then come from there
+    bool readCentralDirectory() {
+        const uint8_t* zip = file.data();
+        size_t zipSize = file.size();
+        if (zipSize < 22) return false;
+        size_t endRecord = SIZE_MAX;
+        size_t searchStart = zipSize > 22 + 0xFFFF ? zipSize - 22 - 0xFFFF : 0; // the comment is at most 64k
+        for (size_t at = zipSize - 22 + 1; at-- > searchStart;) {
+            if (le32(zip + at) == 0x06054b50) { endRecord = at; break; }
+        }
+        if (endRecord == SIZE_MAX) return false;
+        uint64_t entryCount = le16(zip + endRecord + 10);
+        uint64_t directorySize = le32(zip + endRecord + 12);
+        uint64_t directoryOffset = le32(zip + endRecord + 16);
+        if (endRecord >= 20 && le32(zip + endRecord - 20) == 0x07064b50) {
+            uint64_t end64 = le64(zip + endRecord - 20 + 8);
+            if (end64 > zipSize || zipSize - end64 < 56 || le32(zip + end64) != 0x06064b50) return false;
+            entryCount = le64(zip + end64 + 32);
+            directorySize = le64(zip + end64 + 40);
+            directoryOffset = le64(zip + end64 + 48);
+        }
+        if (directoryOffset > zipSize || directorySize > zipSize - directoryOffset) return false;
+
+        const uint8_t* at = zip + directoryOffset;
+        const uint8_t* end = at + directorySize;
+        for (uint64_t i = 0; i < entryCount; i++) {
+            if (end - at < 46 || le32(at) != 0x02014b50) return false;
+            uint16_t flags = le16(at + 8);
+            size_t nameLength = le16(at + 28);
+            size_t extraLength = le16(at + 30);
+            size_t commentLength = le16(at + 32);
+            if (static_cast<size_t>(end - at) < 46 + nameLength + extraLength + commentLength) return false;
+            Entry entry;
+            entry.method = le16(at + 10);
+            entry.compressedSize = le32(at + 20);
+            entry.uncompressedSize = le32(at + 24);
+            entry.localOffset = le32(at + 42);
+            entry.name.assign(reinterpret_cast<const char*>(at + 46), nameLength);
+            // Zip64 extra field, only the fields saturated in the fixed header are present, in this order
+            for (const uint8_t* extra = at + 46 + nameLength; extra + 4 <= at + 46 + nameLength + extraLength;) {
+                uint16_t id = le16(extra);
+                uint16_t size = le16(extra + 2);
+                const uint8_t* field = extra + 4;
+                const uint8_t* fieldEnd = field + size;
+                if (fieldEnd > at + 46 + nameLength + extraLength) break;
+                if (id == 0x0001) {
+                    for (uint64_t* value : {&entry.uncompressedSize, &entry.compressedSize, &entry.localOffset}) {
+                        if (*value != 0xFFFFFFFF || field + 8 > fieldEnd) continue;
+                        *value = le64(field);
+                        field += 8;
+                    }
+                }
+                extra = fieldEnd;
+            }
+            at += 46 + nameLength + extraLength + commentLength;
+            bool encrypted = flags & 1;
+            bool directory = !entry.name.empty() && entry.name.back() == '/';
+            if (encrypted || directory || (entry.method != 0 && entry.method != 8)) continue;
+            if (entry.method == 0 && entry.compressedSize != entry.uncompressedSize) continue;
+            entries.push_back(std::move(entry));
+        }
+
+        // The shallowest scene.json is the root, macOS resource forks are skipped
+        std::string root;
+        size_t rootDepth = SIZE_MAX;
+        for (const Entry& entry : entries) {
+            if (entry.name.compare(0, 9, "__MACOSX/") == 0) continue;
+            bool isScene = entry.name == "scene.json" ||
+                (entry.name.size() > 11 && entry.name.compare(entry.name.size() - 11, 11, "/scene.json") == 0);
+            if (!isScene) continue;
+            size_t depth = std::count(entry.name.begin(), entry.name.end(), '/');
+            if (depth < rootDepth) {
+                rootDepth = depth;
+                root = entry.name.substr(0, entry.name.size() - 10);
+            }
+        }
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].name.compare(0, root.size(), root) == 0) {
+                byName.emplace(entries[i].name.substr(root.size()), static_cast<int>(i));
+            }
+        }
+        return true;
+    }
+
+    // Local header: signature, fixed fields, then its own name and extra lengths which can differ from the central one
+    bool entryData(const Entry& entry, const uint8_t*& outData) const {
+        size_t zipSize = file.size();
+        if (entry.localOffset > zipSize || zipSize - entry.localOffset < 30) return false;
+        const uint8_t* local = file.data() + entry.localOffset;
+        if (le32(local) != 0x04034b50) return false;
+        uint64_t dataOffset = entry.localOffset + 30 + le16(local + 26) + le16(local + 28);
+        if (dataOffset > zipSize || entry.compressedSize > zipSize - dataOffset) return false;
+        outData = file.data() + dataOffset;
+        return true;
+    }
+
+    VmaxMappedFile file;
+    bool opened = false;
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, int> byName;
+    std::unique_ptr<std::once_flag[]> once;
+    std::vector<std::shared_ptr<const std::vector<uint8_t>>> inflated;
+};
+
+// Zip archives currently readable as if they were a .vmax directory, see VmaxZipMount
+struct VmaxZipMounts {
+    std::mutex mutex;
+    std::map<std::string, std::pair<std::shared_ptr<VmaxZipArchive>, int>> archives; // path -> archive, mount count
+};
+
+inline VmaxZipMounts& vmaxZipMounts() {
+    static VmaxZipMounts mounts;
+    return mounts;
+}
+
+// Makes the files of a .zip readable through VmaxSourceFile as <zip path>/<name> while it lives
+// Does nothing for anything that is not a regular file ending in .zip, so callers can mount every input
+// Mounting the same path again shares the open archive
+class VmaxZipMount {
+public:
+    explicit VmaxZipMount(std::string zipFileName) {
+        while (!zipFileName.empty() && (zipFileName.back() == '/' || zipFileName.back() == '\\')) zipFileName.pop_back();
+        std::error_code error;
+        bool isZip = zipFileName.size() > 4 && zipFileName.compare(zipFileName.size() - 4, 4, ".zip") == 0 &&
+                     std::filesystem::is_regular_file(zipFileName, error);
+        if (!isZip) return;
+        VmaxZipMounts& mounts = vmaxZipMounts();
+        std::lock_guard<std::mutex> lock(mounts.mutex);
+        auto& mounted = mounts.archives[zipFileName];
+        if (!mounted.first) {
+            mounted.first = std::make_shared<VmaxZipArchive>(zipFileName);
+            if (!mounted.first->isOpen()) {
+                mounts.archives.erase(zipFileName);
+                throw std::runtime_error("Not a readable zip archive: " + zipFileName);
+            }
+        }
+        mounted.second++;
+        path = zipFileName;
+    }
+
+    ~VmaxZipMount() {
+        if (path.empty()) return;
+        VmaxZipMounts& mounts = vmaxZipMounts();
+        std::lock_guard<std::mutex> lock(mounts.mutex);
+        auto mounted = mounts.archives.find(path);
+        if (mounted != mounts.archives.end() && --mounted->second.second == 0) mounts.archives.erase(mounted);
+    }
+
+    VmaxZipMount(const VmaxZipMount&) = delete;
+    VmaxZipMount& operator=(const VmaxZipMount&) = delete;
+
+private:
+    std::string path;
+};
+
+// Read only bytes of an input file, either a file on disk (memory mapped) or an entry of a mounted zip
+// Same interface as VmaxMappedFile, every reader of .vmax files goes through this
+class VmaxSourceFile {
+public:
+    explicit VmaxSourceFile(const std::string& fileName) {
+        std::shared_ptr<VmaxZipArchive> zip;
+        std::string entryName;
+        {
+            VmaxZipMounts& mounts = vmaxZipMounts();
+            std::lock_guard<std::mutex> lock(mounts.mutex);
+            for (const auto& [zipFileName, mounted] : mounts.archives) {
+                if (fileName.size() > zipFileName.size() && fileName.compare(0, zipFileName.size(), zipFileName) == 0 &&
+                    (fileName[zipFileName.size()] == '/' || fileName[zipFileName.size()] == '\\')) {
+                    size_t entryStart = fileName.find_first_not_of("/\\", zipFileName.size());
+                    if (entryStart == std::string::npos) break; // "foo.zip/" names the zip, not an entry
+                    zip = mounted.first;
+                    entryName = fileName.substr(entryStart);
+                    break;
+                }
+            }
+        }
+        if (!zip) {
+            file = std::make_unique<VmaxMappedFile>(fileName);
+            opened = file->isOpen();
+            bytes = file->data();
+            byteSize = file->size();
+            return;
+        }
+        std::replace(entryName.begin(), entryName.end(), '\\', '/');
+        opened = zip->read(zip->find(entryName), bytes, byteSize);
+        if (opened) archive = std::move(zip); // keeps the map and the inflated bytes alive
+    }
+
+    VmaxSourceFile(const VmaxSourceFile&) = delete;
+    VmaxSourceFile& operator=(const VmaxSourceFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return byteSize; }
+
+private:
+    bool opened = false;
+    const uint8_t* bytes = nullptr;
+    size_t byteSize = 0;
+    std::unique_ptr<VmaxMappedFile> file;
+    std::shared_ptr<VmaxZipArchive> archive;
+};
+
+// Read a 256x1 PNG file and return a vector of VmaxRGBA colors
+std::vector<VmaxRGBA> read256x1PaletteFromPNG(const std::string& filename) {
+    int width, height, channels;
+    // Load the image with 4 desired channels (RGBA), from disk or a mounted zip
+    VmaxSourceFile pngFile(filename);
+    unsigned char* data = pngFile.isOpen() ? stbi_load_from_memory(pngFile.data(), static_cast<int>(pngFile.size()), 
+                                                                   &width, &height, &channels, 4) : nullptr;
+    
+    if (!data) {
+        std::cerr << "Error loading PNG file: " << filename << std::endl;
+        return {};
+    }
+    // Make sure the image is 256x1 as expected
+    if (width != 256 || height != 1) {
+        std::cerr << "Warning: Expected a 256x1 image, but got " << width << "x" << height << std::endl;
+    }
+    // Create our palette array
+    std::vector<VmaxRGBA> palette;
+    // Read each pixel (each pixel is 4 bytes - RGBA)
+    for (int i = 0; i < width; i++) {
+        VmaxRGBA color;
+        color.r = data[i * 4];
+        color.g = data[i * 4 + 1];
+        color.b = data[i * 4 + 2];
+        color.a = data[i * 4 + 3];
+        palette.push_back(color);
+    }
+    stbi_image_free(data); // Free the image data
+    return palette;
+}
+
+// Exact decoded size of an LZFSE stream, found by walking its block headers
+// Every block header stores its raw (decoded) size, the compressed size depends on the block type
+// @return decoded size, 0 if the stream does not look like a well formed LZFSE stream
+inline size_t lzfseDecodedSize(const uint8_t* src, size_t srcSize) {
+    auto read32 = [&](size_t at) {
+        uint32_t value;
+        std::memcpy(&value, src + at, 4);
+        return value;  // LZFSE headers are little endian, like every platform we build for
+    };
+    auto read64 = [&](size_t at) {
+        uint64_t value;
+        std::memcpy(&value, src + at, 8);
+        return value;
+    };
+    size_t decodedSize = 0;
+    size_t at = 0;
+    while (at + 4 <= srcSize) {
+        uint32_t magic = read32(at);
+        if (magic == 0x24787662) { // "bvx$" end of stream
+            return decodedSize;
+        }
+        if (at + 8 > srcSize) return 0;
+        uint64_t rawBytes = read32(at + 4);
+        uint64_t blockSize = 0;
+        if (magic == 0x2d787662) {          // "bvx-" uncompressed
+            blockSize = 8 + rawBytes;
+        } else if (magic == 0x6e787662) {   // "bvxn" lzvn, magic, raw, payload
+            if (at + 12 > srcSize) return 0;
+            blockSize = 12 + uint64_t(read32(at + 8));
+        } else if (magic == 0x32787662) {   // "bvx2" lzfse v2, sizes packed in 3 64 bit fields
+            if (at + 32 > srcSize) return 0;
+            uint64_t v0 = read64(at + 8);
+            uint64_t v1 = read64(at + 16);
+            uint64_t v2 = read64(at + 24);
+            uint64_t literalPayloadBytes = (v0 >> 20) & 0xfffff;
+            uint64_t lmdPayloadBytes = (v1 >> 40) & 0xfffff;
+            uint64_t headerSize = v2 & 0xffffffff;
+            blockSize = headerSize + literalPayloadBytes + lmdPayloadBytes;
+        } else {
+            return 0; // "bvx1" only exists in memory, anything else is not lzfse
+        }
+        if (blockSize == 0 || at + blockSize > srcSize) return 0;
+        decodedSize += rawBytes;
+        at += blockSize;
+    }
+    return 0; // ran out of input before the end of stream marker
+}
+
+// LZFSE scratch space, allocated once per thread and reused for every decode
+inline uint8_t* lzfseScratch() {
+    thread_local std::vector<uint8_t> scratch(lzfse_decode_scratch_size());
+    return scratch.data();
+}
+
+// Decode an LZFSE stream into outBuffer
+// The output is sized exactly from the block headers, the grow and retry loop
+// is only used for streams whose headers we can not walk
+// @return decoded size, 0 on failure
+// Buffer is any byte vector, decodeVmaxModel() passes one backed by the thread arena
+template <typename Buffer>
+inline size_t decodeLZFSE(const uint8_t* src, size_t srcSize, Buffer& outBuffer) {
+    size_t expectedSize = lzfseDecodedSize(src, srcSize);
+    if (expectedSize > 0) {
+        // one spare byte tells an exact fit apart from a truncated decode
+        outBuffer.resize(expectedSize + 1);
+        size_t decodedSize = lzfse_decode_buffer(outBuffer.data(), outBuffer.size(), src, srcSize, lzfseScratch());
+        if (decodedSize == expectedSize) {
+            outBuffer.resize(decodedSize);
+            return decodedSize;
+        }
+    }
+    // Unknown size, start with output buffer 8x input size and double it until it fits
+    size_t outAllocatedSize = std::max<size_t>(srcSize * 8, 4096);
+    for (int attempt = 0; attempt < 16; attempt++) {
+        if (expectedSize > 0 || attempt > 0) vmaxStats().lzfseRetries++;
+        outBuffer.resize(outAllocatedSize);
+        size_t decodedSize = lzfse_decode_buffer(outBuffer.data(), outAllocatedSize, src, srcSize, lzfseScratch());
+        // decodedSize == outAllocatedSize might mean buffer was too small
+        if (decodedSize != 0 && decodedSize < outAllocatedSize) {
+            outBuffer.resize(decodedSize);
+            return decodedSize;
+        }
+        outAllocatedSize *= 2;
+    }
+    outBuffer.clear();
+    return 0;
 }
 
 /**
@@ -530,8 +2021,8 @@ std::vector<VmaxVoxel> vmaxVoxelInfo(plist_t& plist_datastream, uint64_t chunkID
  * if the file is lzfse compressed, decompress it and parse the decompressed data
  * 
  * Memory Management:
- * - Creates temporary buffers for decompression
- * - Handles buffer resizing if needed
+ * - The input file is memory mapped, never copied
+ * - Compressed files are decoded once into a buffer of the exact decoded size
  * - Returns a plist node that must be freed by the caller
  * 
  * @param lzfseFullName Path to the LZFSE file
@@ -540,83 +2031,39 @@ std::vector<VmaxVoxel> vmaxVoxelInfo(plist_t& plist_datastream, uint64_t chunkID
  */
 // read binary lzfse compressed/uncompressed file 
 inline plist_t readPlist(const std::string& inStrPlist, std::string outStrPlist, bool decompress) {
-    // Get file size using std::filesystem
-    size_t rawFileSize = std::filesystem::file_size(inStrPlist);
-    std::vector<uint8_t> rawBytes(rawFileSize);
+    VmaxStatTimer timer(vmaxStats().plistNanos);
+    VmaxSourceFile rawFile(inStrPlist);
+    if (!rawFile.isOpen()) {
+        std::cerr << "Error: Could not open plist file: " << inStrPlist << std::endl;
+        throw std::runtime_error("Could not open plist file: " + inStrPlist); // [learned] no need to return nullptr
+    }
+
+    const uint8_t* plistBytes = rawFile.data(); // uncompressed files are parsed straight from the map
+    size_t plistSize = rawFile.size();
+    vmaxStats().plistFiles++;
+    vmaxStats().plistBytesIn += rawFile.size();
     std::vector<uint8_t> outBuffer;
-    size_t decodedSize = 0;
     if (decompress) { // files are either lzfse compressed or uncompressed
-        std::ifstream rawBytesFile(inStrPlist, std::ios::binary);
-        if (!rawBytesFile.is_open()) {
-            std::cerr << "Error: Could not open plist file: " << inStrPlist << std::endl;
-            throw std::runtime_error("Error message"); // [learned] no need to return nullptr
-        }
-        
-        rawBytesFile.read(reinterpret_cast<char*>(rawBytes.data()), rawFileSize);
-        rawBytesFile.close();
-        // Start with output buffer 4x input size (compression ratio is usually < 4)
-        size_t outAllocatedSize = rawFileSize * 8;
-        // vector<uint8_t> automatically manages memory allocation/deallocation
-        //std::vector<uint8_t> outBuffer(outAllocatedSize);
-        outBuffer.resize(outAllocatedSize);  // Resize preserves existing content
-
-        // LZFSE needs a scratch buffer for its internal operations
-        // Get the required size and allocate it
-        size_t scratchSize = lzfse_decode_scratch_size();
-        std::vector<uint8_t> scratch(scratchSize);
-
-        // Decompress the data, growing the output buffer if needed
-        //size_t decodedSize = 0;
-        while (true) {
-            // Try to decompress with current buffer size
-            decodedSize = lzfse_decode_buffer(
-                outBuffer.data(),     // Where to store decompressed data
-                outAllocatedSize,     // Size of output buffer
-                rawBytes.data(),            // Source of compressed data
-                rawBytes.size(),            // Size of compressed data
-                scratch.data());      // Scratch space for LZFSE
-
-            // Check if we need a larger buffer:
-            // - decodedSize == 0 indicates failure
-            // - decodedSize == outAllocatedSize might mean buffer was too small
-            if (decodedSize == 0 || decodedSize == outAllocatedSize) {
-                outAllocatedSize *= 2;  // Double the buffer size
-                outBuffer.resize(outAllocatedSize);  // Resize preserves existing content
-                continue;  // Try again with larger buffer
-            }
-            break;  // Successfully decompressed
-        }
-
-        // Check if decompression failed
-        if (decodedSize == 0) {
+        plistSize = decodeLZFSE(rawFile.data(), rawFile.size(), outBuffer);
+        if (plistSize == 0) {
             std::cerr << "Failed to decompress data" << std::endl;
             return nullptr;
         }
+        plistBytes = outBuffer.data();
 
         // If requested, write the decompressed data to a file
         if (!outStrPlist.empty()) {
             std::ofstream outFile(outStrPlist, std::ios::binary);
             if (outFile) {
-                outFile.write(reinterpret_cast<const char*>(outBuffer.data()), decodedSize);
+                outFile.write(reinterpret_cast<const char*>(plistBytes), plistSize);
                 std::cout << "Wrote decompressed plist to: " << outStrPlist << std::endl;
             } else {
                 std::cerr << "Failed to write plist to file: " << outStrPlist << std::endl;
             }
         }
-    } else {
-        outBuffer.resize(rawFileSize); 
-        // if the file is not compressed, just read the raw bytes
-        std::ifstream rawBytesFile(inStrPlist, std::ios::binary);
-        if (!rawBytesFile.is_open()) {
-            std::cerr << "Error: Could not open plist file: " << inStrPlist << std::endl;
-            throw std::runtime_error("Error message"); // [learned] no need to return nullptr
-        }
-        rawBytesFile.read(reinterpret_cast<char*>(outBuffer.data()), rawFileSize);
-        rawBytesFile.close();
-        decodedSize = rawFileSize; // decodedSize is the same as rawFileSize when data is not compressed
-
+    }
 
-    } // outBuffer now contains the raw bytes of the plist file
+    vmaxStats().plistBytesOut += plistSize;
 
     // Parse the decompressed data as a plist
     plist_t root_node = nullptr;
@@ -624,10 +2071,10 @@ inline plist_t readPlist(const std::string& inStrPlist, std::string outStrPlist,
     
     // Convert the raw decompressed data into a plist structure
     plist_err_t err = plist_from_memory(
-        reinterpret_cast<const char*>(outBuffer.data()),  // Cast uint8_t* to char*
-        static_cast<uint32_t>(decodedSize),               // Cast size_t to uint32_t
-        &root_node,                                       // Where to store the parsed plist
-        &format);                                         // Where to store the format
+        reinterpret_cast<const char*>(plistBytes),  // Cast uint8_t* to char*
+        static_cast<uint32_t>(plistSize),           // Cast size_t to uint32_t
+        &root_node,                                 // Where to store the parsed plist
+        &format);                                   // Where to store the format
     
     // Check if parsing succeeded
     if (err != PLIST_ERR_SUCCESS) {
@@ -643,6 +2090,254 @@ inline plist_t readPlist(const std::string& inStrPlist, bool decompress) {
     return readPlist(inStrPlist, "", decompress);
 }
 
+// Read and LZFSE decode a whole contentsN.vmaxb, counted like readPlist() in vmaxStats()
+// @param outBytes: the decompressed binary plist
+// @return false if the file could not be opened or decoded
+template <typename Buffer>
+inline bool readVmaxbBytes(const std::string& fileName, Buffer& outBytes) {
+    VmaxStatTimer timer(vmaxStats().plistNanos);
+    VmaxSourceFile rawFile(fileName);
+    if (!rawFile.isOpen()) {
+        std::cerr << "Error: Could not open plist file: " << fileName << std::endl;
+        return false;
+    }
+    vmaxStats().plistFiles++;
+    vmaxStats().plistBytesIn += rawFile.size();
+    size_t plistSize = decodeLZFSE(rawFile.data(), rawFile.size(), outBytes);
+    if (plistSize == 0) {
+        std::cerr << "Failed to decompress data" << std::endl;
+        return false;
+    }
+    vmaxStats().plistBytesOut += plistSize;
+    return true;
+}
+
+// Read only view of a bplist00 buffer, objects are looked up through the offset table on demand
+// Nothing is allocated, data and strings point into the buffer which must outlive the reader
+// Every accessor checks bounds and returns false on anything malformed
+// Format: "bplist00", objects, offset table, 32 byte trailer
+//   trailer: 6 unused, offset int size, object ref size, object count, top object, offset table start (u64 big endian)
+//   object marker: high nibble type, low nibble count (0xF: an int object with the count follows)
+class VmaxBplist {
+public:
+    enum Type : uint8_t { Simple = 0x0, Int = 0x1, Real = 0x2, Date = 0x3, Data = 0x4, Ascii = 0x5, Utf16 = 0x6,
+                          Uid = 0x8, Array = 0xA, Set = 0xC, Dict = 0xD };
+
+    // @return false if the buffer is not a bplist00 with a sane trailer
+    bool open(const uint8_t* data, size_t size) {
+        bytes = data;
+        byteCount = size;
+        if (size < 8 + 32 || std::memcmp(data, "bplist00", 8) != 0) return false;
+        const uint8_t* trailer = data + size - 32;
+        offsetIntSize = trailer[6];
+        objectRefSize = trailer[7];
+        objectCount = readBigEndian(trailer + 8, 8);
+        topObject = readBigEndian(trailer + 16, 8);
+        offsetTable = readBigEndian(trailer + 24, 8);
+        if (offsetIntSize < 1 || offsetIntSize > 8 || objectRefSize < 1 || objectRefSize > 8) return false;
+        if (topObject >= objectCount || offsetTable < 8 || offsetTable > size - 32) return false;
+        if (objectCount > (size - 32 - offsetTable) / offsetIntSize) return false;
+        return true;
+    }
+
+    uint64_t root() const { return topObject; }
+
+    // Marker of an object, count is elements for arrays and dicts, bytes for data and ascii
+    // @param outPayload: first byte after the marker and count
+    bool object(uint64_t ref, uint8_t& outType, uint64_t& outCount, const uint8_t*& outPayload) const {
+        if (ref >= objectCount) return false;
+        uint64_t offset = readBigEndian(bytes + offsetTable + ref * offsetIntSize, offsetIntSize);
+        if (offset < 8 || offset >= offsetTable) return false;
+        const uint8_t* at = bytes + offset;
+        const uint8_t* end = bytes + offsetTable;
+        outType = at[0] >> 4;
+        outCount = at[0] & 0x0F;
+        at++;
+        if (outCount == 0x0F && outType != Simple && outType != Int && outType != Real && outType != Date) {
+            if (at >= end || (at[0] >> 4) != Int) return false;
+            size_t countSize = size_t(1) << (at[0] & 0x0F);
+            if (countSize > 8 || at + 1 + countSize > end) return false;
+            outCount = readBigEndian(at + 1, countSize);
+            at += 1 + countSize;
+        }
+        outPayload = at;
+        // Make sure the whole payload is inside the object area, counts come from the file
+        // so compare against available / elementSize instead of multiplying
+        uint64_t available = static_cast<uint64_t>(end - at);
+        switch (outType) {
+            case Int: case Real: return outCount < 64 && (uint64_t(1) << outCount) <= available;
+            case Date: return 8 <= available;
+            case Data: case Ascii: return outCount <= available;
+            case Utf16: return outCount <= available / 2;
+            case Uid: return outCount < available;
+            case Array: case Set: return outCount <= available / objectRefSize;
+            case Dict: return outCount <= available / (2 * uint64_t(objectRefSize));
+            default: return true;
+        }
+    }
+
+    // Value of key in a dict, keys are compared as ascii
+    bool dictGet(uint64_t dictRef, const char* key, uint64_t& outRef) const {
+        uint8_t type;
+        uint64_t count;
+        const uint8_t* payload;
+        if (!object(dictRef, type, count, payload) || type != Dict) return false;
+        size_t keyLength = std::strlen(key);
+        for (uint64_t i = 0; i < count; i++) {
+            uint8_t keyType;
+            uint64_t keyCount;
+            const uint8_t* keyBytes;
+            if (!object(readBigEndian(payload + i * objectRefSize, objectRefSize), keyType, keyCount, keyBytes)) continue;
+            if (keyType == Ascii && keyCount == keyLength && std::memcmp(keyBytes, key, keyLength) == 0) {
+                outRef = readBigEndian(payload + (count + i) * objectRefSize, objectRefSize);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Same as dictGet() down a path of nested dicts
+    bool dictGet(uint64_t dictRef, std::initializer_list<const char*> path, uint64_t& outRef) const {
+        outRef = dictRef;
+        for (const char* key : path) {
+            if (!dictGet(outRef, key, outRef)) return false;
+        }
+        return true;
+    }
+
+    bool arraySize(uint64_t arrayRef, uint64_t& outCount) const {
+        uint8_t type;
+        const uint8_t* payload;
+        return object(arrayRef, type, outCount, payload) && type == Array;
+    }
+
+    bool arrayGet(uint64_t arrayRef, uint64_t index, uint64_t& outRef) const {
+        uint8_t type;
+        uint64_t count;
+        const uint8_t* payload;
+        if (!object(arrayRef, type, count, payload) || type != Array || index >= count) return false;
+        outRef = readBigEndian(payload + index * objectRefSize, objectRefSize);
+        return true;
+    }
+
+    // 1, 2 and 4 byte ints are unsigned, 8 byte ints signed, 16 byte ints keep their low 8 bytes
+    // Reals are truncated, a writer may store whole numbers as floats
+    bool getUInt(uint64_t ref, uint64_t& outValue) const {
+        uint8_t type;
+        uint64_t sizeLog2;
+        const uint8_t* payload;
+        if (!object(ref, type, sizeLog2, payload)) return false;
+        if (type == Real && (sizeLog2 == 2 || sizeLog2 == 3)) {
+            uint64_t raw = readBigEndian(payload, size_t(1) << sizeLog2);
+            double value;
+            if (sizeLog2 == 2) {
+                uint32_t raw32 = static_cast<uint32_t>(raw);
+                float value32;
+                std::memcpy(&value32, &raw32, 4);
+                value = value32;
+            } else {
+                std::memcpy(&value, &raw, 8);
+            }
+            if (!(value >= 0.0 && value < 18446744073709551616.0)) return false;
+            outValue = static_cast<uint64_t>(value);
+            return true;
+        }
+        if (type != Int || sizeLog2 > 4) return false;
+        size_t size = size_t(1) << sizeLog2;
+        outValue = readBigEndian(payload + (size > 8 ? size - 8 : 0), std::min<size_t>(size, 8));
+        return true;
+    }
+
+    // Borrowed pointer to the bytes of a data object
+    bool getData(uint64_t ref, const uint8_t*& outData, uint64_t& outLength) const {
+        uint8_t type;
+        const uint8_t* payload;
+        if (!object(ref, type, outLength, payload) || type != Data) return false;
+        outData = payload;
+        return true;
+    }
+
+private:
+    static uint64_t readBigEndian(const uint8_t* at, size_t size) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; i++) value = (value << 8) | at[i];
+        return value;
+    }
+
+    const uint8_t* bytes = nullptr;
+    size_t byteCount = 0;
+    size_t offsetIntSize = 0;
+    size_t objectRefSize = 0;
+    uint64_t objectCount = 0;
+    uint64_t topObject = 0;
+    uint64_t offsetTable = 0;
+};
+
+// The parts of one snapshot the voxel decode needs, ds points into the plist buffer
+struct VmaxSnapshotRecord {
+    bool hasChunk = false;   // s.id.c present, snapshots without one are ignored
+    int64_t chunkID = -1;    // s.id.c, -1 if s.id.t or s.st.min[3] is missing too, see vmaxChunkInfo()
+    uint64_t type = 0;       // s.id.t
+    uint64_t mortoncode = 0; // s.st.min[3]
+    const uint8_t* ds = nullptr;
+    uint64_t dsLength = 0;
+};
+
+// Walk the snapshots array of a decompressed contentsN.vmaxb straight from the bplist00 bytes
+// Only s.id.c, s.id.t, s.st.min[3] and s.ds of each snapshot are read, no plist nodes are built
+// @return false if the buffer is not a binary plist with a snapshots array, see vmaxSnapshotsFromPlist()
+template <typename Records>
+inline bool readVmaxSnapshots(const uint8_t* plistBytes, size_t plistSize, Records& outSnapshots) {
+    VmaxBplist plist;
+    uint64_t snapshotsRef, snapshotCount;
+    if (!plist.open(plistBytes, plistSize) || !plist.dictGet(plist.root(), "snapshots", snapshotsRef) ||
+        !plist.arraySize(snapshotsRef, snapshotCount)) {
+        return false;
+    }
+    outSnapshots.clear();
+    outSnapshots.resize(snapshotCount);
+    for (uint64_t i = 0; i < snapshotCount; i++) {
+        VmaxSnapshotRecord& record = outSnapshots[i];
+        uint64_t snapshotRef, sRef, itemRef;
+        if (!plist.arrayGet(snapshotsRef, i, snapshotRef) || !plist.dictGet(snapshotRef, "s", sRef)) continue;
+        uint64_t chunkID = 0;
+        record.hasChunk = plist.dictGet(sRef, {"id", "c"}, itemRef) && plist.getUInt(itemRef, chunkID);
+        bool hasType = plist.dictGet(sRef, {"id", "t"}, itemRef) && plist.getUInt(itemRef, record.type);
+        uint64_t minRef;
+        bool hasMorton = plist.dictGet(sRef, {"st", "min"}, minRef) && plist.arrayGet(minRef, 3, itemRef) &&
+                         plist.getUInt(itemRef, record.mortoncode);
+        if (record.hasChunk && hasType && hasMorton) record.chunkID = static_cast<int64_t>(chunkID);
+        if (plist.dictGet(sRef, "ds", itemRef)) plist.getData(itemRef, record.ds, record.dsLength);
+    }
+    return true;
+}
+
+// Same records from an already parsed plist, for files readVmaxSnapshots() does not take
+// ds points into plist_model_root which must outlive the records
+template <typename Records>
+inline void vmaxSnapshotsFromPlist(plist_t plist_model_root, Records& outSnapshots) {
+    plist_t plist_snapshots_array = plist_dict_get_item(plist_model_root, "snapshots");
+    uint32_t snapshots_array_size = plist_snapshots_array ? plist_array_get_size(plist_snapshots_array) : 0;
+    outSnapshots.clear();
+    outSnapshots.resize(snapshots_array_size);
+    for (uint32_t i = 0; i < snapshots_array_size; i++) {
+        VmaxSnapshotRecord& record = outSnapshots[i];
+        plist_t plist_snapshot = plist_array_get_item(plist_snapshots_array, i);
+        // Same test as the bplist walker, c has to be a non negative number not just present
+        plist_t plist_chunk = getNestedPlistNode(plist_snapshot, {"s", "id", "c"});
+        plist_type chunkType = plist_chunk ? plist_get_node_type(plist_chunk) : PLIST_NONE;
+        double realChunk = -1.0;
+        if (chunkType == PLIST_REAL) plist_get_real_val(plist_chunk, &realChunk);
+        record.hasChunk = chunkType == PLIST_INT || (realChunk >= 0.0 && realChunk < 18446744073709551616.0);
+        if (!record.hasChunk) continue;
+        VmaxChunkInfo chunkInfo = vmaxChunkInfo(plist_snapshot);
+        record.chunkID = chunkType == PLIST_REAL ? static_cast<int64_t>(static_cast<uint64_t>(realChunk)) : chunkInfo.id;
+        record.type = chunkInfo.type;
+        record.mortoncode = chunkInfo.mortoncode;
+        record.ds = borrowPlistData(getNestedPlistNode(plist_snapshot, {"s", "ds"}), record.dsLength);
+    }
+}
+
 // Structure to hold object/model information from VoxelMax's scene.json
 struct JsonModelInfo {
     std::string id;
@@ -686,17 +2381,15 @@ private:
 public:
     bool parseScene(const std::string& jsonFilePath) {
         try {
-            // Read the JSON file
-            std::ifstream file(jsonFilePath);
-            if (!file.is_open()) {
+            // Read the JSON file, from disk or a mounted zip
+            VmaxSourceFile file(jsonFilePath);
+            if (!file.isOpen()) {
                 std::cerr << "Failed to open file: " << jsonFilePath << std::endl;
                 return false;
             }
             
             // Parse the JSON
-            json sceneData;
-            file >> sceneData;
-            file.close();
+            json sceneData = json::parse(file.data(), file.data() + file.size());
             
             // Parse groups
             if (sceneData.contains("groups") && sceneData["groups"].is_array()) {
@@ -858,6 +2551,1181 @@ public:
         }
     }
 };
+
+// Bella node name of a scene.json id, uuids use - which is not allowed in a node name
+inline std::string vmaxNodeName(const std::string& vmaxId) {
+    std::string nodeName = "_" + vmaxId;
+    std::replace(nodeName.begin(), nodeName.end(), '-', '_');
+    return nodeName;
+}
+
+// Transform of a scene.json group or object, defaults are used for missing t_r, t_p, t_s
+struct VmaxSceneTransform {
+    std::array<double, 4> rotation = {0.0, 0.0, 0.0, 1.0}; // t_r quaternion
+    std::array<double, 3> position = {0.0, 0.0, 0.0};      // t_p
+    std::array<double, 3> scale = {1.0, 1.0, 1.0};         // t_s
+    bool operator==(const VmaxSceneTransform& other) const {
+        return rotation == other.rotation && position == other.position && scale == other.scale;
+    }
+    bool operator!=(const VmaxSceneTransform& other) const { return !(*this == other); }
+};
+
+// A group of scene.json, an xform in Bella
+struct VmaxSceneGroup {
+    uint32_t id = 0;        // interned, see VmaxScene::ids
+    int32_t parent = -1;    // index into VmaxScene::groups, -1 for the world
+    std::string nodeName;   // vmaxNodeName(id)
+    VmaxSceneTransform transform;
+};
+
+// An object of scene.json, an instance of one content (contentsN.vmaxb)
+struct VmaxSceneObject {
+    uint32_t id = 0;
+    int32_t parent = -1;    // index into VmaxScene::groups, -1 for the world
+    uint32_t content = 0;   // index into VmaxScene::contents
+    std::string nodeName;
+    VmaxSceneTransform transform;
+    bool hasExtent = false; // both e_mi and e_ma were given
+    std::array<double, 3> extentMin = {0.0, 0.0, 0.0}; // e_mi, model space voxel bounds
+    std::array<double, 3> extentMax = {0.0, 0.0, 0.0}; // e_ma
+};
+
+// A model shared by one or more objects
+struct VmaxSceneContent {
+    std::string nodeName;           // canonical Bella node, dataFile without .vmaxb
+    JsonModelInfo files;            // id, dataFile, paletteFile and historyFile of the first object, what decodeVmaxModel needs
+    std::vector<uint32_t> objects;  // indexes into VmaxScene::objects, in file order
+};
+
+// scene.json as flat records, read in one pass with a SAX handler instead of a json DOM
+// Ids are interned once and every Bella node name is made while reading
+// Contents are sorted by data file, the same order getModelContentVMaxbMap() gave
+class VmaxScene {
+public:
+    std::vector<std::string> ids;   // interned scene.json ids, groups and objects
+    std::vector<VmaxSceneGroup> groups;
+    std::vector<VmaxSceneObject> objects;
+    std::vector<VmaxSceneContent> contents;
+
+    // @return false if the file can not be read or is not valid json, errors go to std::cerr
+    bool parse(const std::string& jsonFilePath) {
+        VmaxSourceFile jsonFile(jsonFilePath);
+        if (!jsonFile.isOpen()) {
+            std::cerr << "Failed to open file: " << jsonFilePath << std::endl;
+            return false;
+        }
+        return parse(reinterpret_cast<const char*>(jsonFile.data()), jsonFile.size());
+    }
+
+    bool parse(const char* jsonText, size_t jsonSize) {
+        *this = VmaxScene();
+        SceneSax sax(*this);
+        bool parsedOk = false;
+        try {
+            parsedOk = json::sax_parse(jsonText, jsonText + jsonSize, &sax);
+        } catch (const std::exception& e) {
+            std::cerr << "Error parsing JSON: " << e.what() << std::endl;
+        }
+        if (!parsedOk) {
+            *this = VmaxScene();
+            return false;
+        }
+        resolve(sax);
+        return true;
+    }
+
+    const std::string& idOf(uint32_t id) const { return ids[id]; }
+
+    // Parent id as in scene.json, empty for the world
+    std::string parentIdOfGroup(size_t groupIndex) const {
+        int32_t parent = groups[groupIndex].parent;
+        return parent < 0 ? std::string() : ids[groups[parent].id];
+    }
+    std::string parentIdOfObject(size_t objectIndex) const {
+        int32_t parent = objects[objectIndex].parent;
+        return parent < 0 ? std::string() : ids[groups[parent].id];
+    }
+
+private:
+    // What the handler collects for one group or object before it is resolved
+    struct PendingRecord {
+        uint32_t id = 0;
+        bool hasId = false;
+        uint32_t parentId = 0;
+        bool hasParent = false;
+        std::string dataFile, paletteFile, historyFile;
+        VmaxSceneTransform transform;
+        std::array<double, 3> extentMin = {0.0, 0.0, 0.0};
+        std::array<double, 3> extentMax = {0.0, 0.0, 0.0};
+        bool hasExtentMin = false, hasExtentMax = false;
+    };
+
+    uint32_t intern(std::string& vmaxId, std::unordered_map<std::string, uint32_t>& idIndex) {
+        auto found = idIndex.find(vmaxId);
+        if (found != idIndex.end()) return found->second;
+        uint32_t id = static_cast<uint32_t>(ids.size());
+        idIndex.emplace(vmaxId, id);
+        ids.push_back(std::move(vmaxId));
+        return id;
+    }
+
+    // Only the fields the conversion uses are kept: id, pid, data, pal, hist, t_r, t_p, t_s, e_mi, e_ma
+    // Everything at other depths is skipped without being stored
+    class SceneSax : public nlohmann::json_sax<json> {
+    public:
+        explicit SceneSax(VmaxScene& target) : scene(target) {}
+
+        std::unordered_map<std::string, uint32_t> idIndex;
+        std::vector<PendingRecord> pendingGroups;
+        std::vector<PendingRecord> pendingObjects;
+
+        bool null() override { return true; }
+        bool boolean(bool) override { return true; }
+        bool number_integer(number_integer_t value) override { return number(static_cast<double>(value)); }
+        bool number_unsigned(number_unsigned_t value) override { return number(static_cast<double>(value)); }
+        bool number_float(number_float_t value, const string_t&) override { return number(value); }
+        bool binary(binary_t&) override { return true; }
+
+        bool string(string_t& value) override {
+            if (depth != 3 || !inRecord) return true;
+            if (currentKey == "id") {
+                record.id = scene.intern(value, idIndex);
+                record.hasId = true;
+            } else if (currentKey == "pid") {
+                if (!value.empty()) {
+                    record.parentId = scene.intern(value, idIndex);
+                    record.hasParent = true;
+                }
+            } else if (section == Objects) {
+                if (currentKey == "data") record.dataFile = std::move(value);
+                else if (currentKey == "pal") record.paletteFile = std::move(value);
+                else if (currentKey == "hist") record.historyFile = std::move(value);
+            }
+            return true;
+        }
+
+        bool start_object(std::size_t) override {
+            depth++;
+            if (depth == 3 && section != None) {
+                record = PendingRecord();
+                inRecord = true;
+            }
+            return true;
+        }
+
+        bool end_object() override {
+            if (depth == 3 && inRecord) {
+                if (record.hasId) (section == Groups ? pendingGroups : pendingObjects).push_back(std::move(record));
+                inRecord = false;
+            }
+            depth--;
+            return true;
+        }
+
+        bool start_array(std::size_t) override {
+            depth++;
+            if (depth == 2) {
+                section = currentKey == "groups" ? Groups : currentKey == "objects" ? Objects : None;
+            } else if (depth == 4 && inRecord) {
+                vector = currentKey == "t_r" ? record.transform.rotation.data() :
+                         currentKey == "t_p" ? record.transform.position.data() :
+                         currentKey == "t_s" ? record.transform.scale.data() :
+                         currentKey == "e_mi" ? record.extentMin.data() :
+                         currentKey == "e_ma" ? record.extentMax.data() : nullptr;
+                vectorSize = currentKey == "t_r" ? 4 : 3;
+                if (currentKey == "e_mi") record.hasExtentMin = true;
+                if (currentKey == "e_ma") record.hasExtentMax = true;
+                vectorIndex = 0;
+            }
+            return true;
+        }
+
+        bool end_array() override {
+            if (depth == 2) section = None;
+            if (depth == 4) vector = nullptr;
+            depth--;
+            return true;
+        }
+
+        bool key(string_t& value) override {
+            if (depth <= 3) currentKey = std::move(value); // deeper keys belong to fields that are not kept
+            return true;
+        }
+
+        bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+            std::cerr << "Error parsing JSON at byte " << position << ": " << ex.what() << std::endl;
+            return false;
+        }
+
+    private:
+        bool number(double value) {
+            if (vector && depth == 4 && vectorIndex < vectorSize) vector[vectorIndex++] = value;
+            return true;
+        }
+
+        enum Section { None, Groups, Objects };
+        VmaxScene& scene;
+        int depth = 0;          // 1 root object, 2 groups/objects array, 3 a record, 4 a field array
+        Section section = None;
+        std::string currentKey;
+        bool inRecord = false;
+        PendingRecord record;
+        double* vector = nullptr; // transform array being filled
+        size_t vectorSize = 0;
+        size_t vectorIndex = 0;
+    };
+
+    // Link parents, name nodes and group objects by content, a later record with the same id replaces an earlier one
+    void resolve(SceneSax& sax) {
+        std::vector<int32_t> groupOfId(ids.size(), -1);
+        for (PendingRecord& pending : sax.pendingGroups) {
+            int32_t& groupIndex = groupOfId[pending.id];
+            if (groupIndex < 0) {
+                groupIndex = static_cast<int32_t>(groups.size());
+                groups.emplace_back();
+            }
+            VmaxSceneGroup& group = groups[groupIndex];
+            group.id = pending.id;
+            group.nodeName = vmaxNodeName(ids[pending.id]);
+            group.transform = pending.transform;
+        }
+        for (PendingRecord& pending : sax.pendingGroups) {
+            groups[groupOfId[pending.id]].parent = pending.hasParent ? groupOfId[pending.parentId] : -1;
+        }
+
+        std::vector<int32_t> objectOfId(ids.size(), -1);
+        std::vector<PendingRecord*> objectRecords;
+        for (PendingRecord& pending : sax.pendingObjects) {
+            int32_t& objectIndex = objectOfId[pending.id];
+            if (objectIndex < 0) {
+                objectIndex = static_cast<int32_t>(objectRecords.size());
+                objectRecords.push_back(&pending);
+            } else {
+                objectRecords[objectIndex] = &pending;
+            }
+        }
+        std::map<std::string, uint32_t> contentOfFile; // sorted, gives the content order
+        for (PendingRecord* pending : objectRecords) contentOfFile.emplace(pending->dataFile, 0);
+        for (auto& [dataFile, contentIndex] : contentOfFile) {
+            contentIndex = static_cast<uint32_t>(contents.size());
+            contents.emplace_back();
+            std::string canonicalName = dataFile;
+            if (canonicalName.size() >= 6 && canonicalName.compare(canonicalName.size() - 6, 6, ".vmaxb") == 0) {
+                canonicalName.erase(canonicalName.size() - 6);
+            }
+            contents.back().nodeName = canonicalName;
+        }
+        objects.resize(objectRecords.size());
+        for (size_t objectIndex = 0; objectIndex < objectRecords.size(); objectIndex++) {
+            PendingRecord& pending = *objectRecords[objectIndex];
+            VmaxSceneObject& object = objects[objectIndex];
+            object.id = pending.id;
+            object.parent = pending.hasParent ? groupOfId[pending.parentId] : -1;
+            object.content = contentOfFile[pending.dataFile];
+            object.nodeName = vmaxNodeName(ids[pending.id]);
+            object.transform = pending.transform;
+            object.hasExtent = pending.hasExtentMin && pending.hasExtentMax;
+            object.extentMin = pending.extentMin;
+            object.extentMax = pending.extentMax;
+            VmaxSceneContent& content = contents[object.content];
+            if (content.objects.empty()) {
+                content.files.id = ids[pending.id];
+                content.files.dataFile = pending.dataFile;
+                content.files.paletteFile = pending.paletteFile;
+                content.files.historyFile = pending.historyFile;
+            }
+            content.objects.push_back(static_cast<uint32_t>(objectIndex));
+        }
+    }
+};
+
+// Controls what decodeVmaxModel reads from a contentsN.vmaxb
+struct VmaxDecodeOptions {
+    // Reconstruct the model as of this snapshot index, later snapshots are ignored, -1 for the current state
+    int64_t snapshotLimit = -1;
+    // Chunks to decode, bit n is chunk morton id n (s.id.c), see vmaxRegionChunkMasks()
+    std::array<uint64_t, 8> chunkMask = {~0ull, ~0ull, ~0ull, ~0ull, ~0ull, ~0ull, ~0ull, ~0ull};
+    // Merge colors of a material closer than this CIE76 deltaE into one bucket, 0 keeps every color, see --merge-colors
+    float mergeColorsDeltaE = 0.0f;
+
+    bool decodesChunk(int64_t chunkID) const {
+        return chunkID < 0 || chunkID >= 512 || ((chunkMask[chunkID >> 6] >> (chunkID & 63)) & 1);
+    }
+    bool decodesAnyChunk() const {
+        for (uint64_t bits : chunkMask) if (bits) return true;
+        return false;
+    }
+};
+
+// Matrix of a scene.json transform, the same one its Bella xform gets
+inline VmaxMatrix4x4 vmaxTransformMatrix(const VmaxSceneTransform& transform) {
+    return combineVmaxTransforms(transform.rotation[0], transform.rotation[1], transform.rotation[2], transform.rotation[3],
+                                 transform.position[0], transform.position[1], transform.position[2],
+                                 transform.scale[0], transform.scale[1], transform.scale[2]);
+}
+
+// Model space to world space of an object, its own transform then each parent group up to the world
+// Row vectors like Bella, a point is p * M, so parents multiply on the right
+inline VmaxMatrix4x4 vmaxObjectWorldMatrix(const VmaxScene& scene, size_t objectIndex) {
+    const VmaxSceneObject& object = scene.objects[objectIndex];
+    VmaxMatrix4x4 world = vmaxTransformMatrix(object.transform);
+    size_t hops = 0; // a parent loop in a broken file must not hang us
+    for (int32_t group = object.parent; group >= 0 && hops++ <= scene.groups.size(); group = scene.groups[group].parent) {
+        world = world * vmaxTransformMatrix(scene.groups[group].transform);
+    }
+    return world;
+}
+
+// Axis aligned box in world space, --region, what lies outside is never decoded or instanced
+struct VmaxRegion {
+    bool enabled = false;
+    std::array<double, 3> min = {0.0, 0.0, 0.0};
+    std::array<double, 3> max = {0.0, 0.0, 0.0};
+
+    // World bounds of a model space box seen through world, all 8 corners are transformed
+    static void worldBounds(const VmaxMatrix4x4& world, const std::array<double, 3>& boxMin, const std::array<double, 3>& boxMax,
+                            std::array<double, 3>& outMin, std::array<double, 3>& outMax) {
+        for (int corner = 0; corner < 8; corner++) {
+            double p[3] = {(corner & 1) ? boxMax[0] : boxMin[0], (corner & 2) ? boxMax[1] : boxMin[1], (corner & 4) ? boxMax[2] : boxMin[2]};
+            for (int axis = 0; axis < 3; axis++) {
+                double w = p[0] * world.m[0][axis] + p[1] * world.m[1][axis] + p[2] * world.m[2][axis] + world.m[3][axis];
+                outMin[axis] = corner == 0 ? w : std::min(outMin[axis], w);
+                outMax[axis] = corner == 0 ? w : std::max(outMax[axis], w);
+            }
+        }
+    }
+
+    // @return 0 outside, 1 partly inside, 2 fully inside, always 2 when not enabled
+    int classify(const VmaxMatrix4x4& world, const std::array<double, 3>& boxMin, const std::array<double, 3>& boxMax) const {
+        if (!enabled) return 2;
+        std::array<double, 3> lo, hi;
+        worldBounds(world, boxMin, boxMax, lo, hi);
+        bool inside = true;
+        for (int axis = 0; axis < 3; axis++) {
+            if (hi[axis] < min[axis] || lo[axis] > max[axis]) return 0;
+            inside = inside && lo[axis] >= min[axis] && hi[axis] <= max[axis];
+        }
+        return inside ? 2 : 1;
+    }
+};
+
+// Which chunks of each content --region needs and which objects it reaches at all
+// An object is tested with its e_mi/e_ma extents first, or the whole 256^3 volume without them,
+// only objects partly inside test their chunks one by one. Voxels are centered on integer positions
+// A chunk is kept when it touches the region through any object using its content, snapshots of the
+// other chunks are skipped before their ds stream is decoded
+// @param outObjectInRegion - per object, false when it can be left out of the scene
+// @return per content a mask for VmaxDecodeOptions::chunkMask, all zero when no object needs the content
+inline std::vector<std::array<uint64_t, 8>> vmaxRegionChunkMasks(const VmaxScene& scene, const VmaxRegion& region, std::vector<bool>& outObjectInRegion) {
+    const std::array<uint64_t, 8> allChunks = VmaxDecodeOptions().chunkMask;
+    std::vector<std::array<uint64_t, 8>> masks(scene.contents.size(), std::array<uint64_t, 8>{});
+    outObjectInRegion.assign(scene.objects.size(), !region.enabled);
+    if (!region.enabled) {
+        std::fill(masks.begin(), masks.end(), allChunks);
+        return masks;
+    }
+    for (size_t objectIndex = 0; objectIndex < scene.objects.size(); objectIndex++) {
+        const VmaxSceneObject& object = scene.objects[objectIndex];
+        std::array<uint64_t, 8>& mask = masks[object.content];
+        VmaxMatrix4x4 world = vmaxObjectWorldMatrix(scene, objectIndex);
+        std::array<double, 3> boxMin = {-0.5, -0.5, -0.5};
+        std::array<double, 3> boxMax = {255.5, 255.5, 255.5};
+        if (object.hasExtent) {
+            for (int axis = 0; axis < 3; axis++) {
+                boxMin[axis] = std::max(boxMin[axis], object.extentMin[axis] - 0.5);
+                boxMax[axis] = std::min(boxMax[axis], object.extentMax[axis] + 0.5);
+            }
+        }
+        int whole = region.classify(world, boxMin, boxMax);
+        if (whole == 0) continue;
+        outObjectInRegion[objectIndex] = true;
+        if (whole == 2) {
+            mask = allChunks;
+            continue;
+        }
+        for (uint32_t chunk = 0; chunk < 512; chunk++) {
+            if ((mask[chunk >> 6] >> (chunk & 63)) & 1) continue; // another object already needs it
+            uint32_t cx, cy, cz;
+            decodeMorton3DOptimized(chunk, cx, cy, cz);
+            std::array<double, 3> chunkMin = {cx * 32.0 - 0.5, cy * 32.0 - 0.5, cz * 32.0 - 0.5};
+            std::array<double, 3> chunkMax = {cx * 32.0 + 31.5, cy * 32.0 + 31.5, cz * 32.0 + 31.5};
+            if (region.classify(world, chunkMin, chunkMax) != 0) mask[chunk >> 6] |= uint64_t(1) << (chunk & 63);
+        }
+    }
+    return masks;
+}
+
+// Everything needed to build one canonical model in Bella
+// Produced by decodeVmaxModel, usually on a worker thread
+struct VmaxDecodedModel {
+    VmaxModel model;
+    std::vector<VmaxRGBA> palette;          // paletteN.png
+    std::array<VmaxMaterial, 8> materials;  // paletteN.settings.vmaxpsb
+    uint32_t snapshotCount = 0;             // snapshots in the file
+    uint32_t snapshotsDecoded = 0;          // latest snapshot of each chunk, the rest are superseded
+
+    VmaxDecodedModel(const std::string& modelName) : model(modelName) {
+    }
+};
+
+// Decode a contentsN.vmaxb with its palette and materials
+// Only reads files and touches no shared state, so it is safe to run one model per thread
+// @param vmaxDirName: the .vmax directory
+// @param vmaxContentName: contentsN.vmaxb, the key from getModelContentVMaxbMap()
+// @param jsonModelInfo: first object using this model, others are instances at the scene level
+// @param options: which snapshots to reconstruct
+// @return decoded model, palette and materials
+inline VmaxDecodedModel decodeVmaxModel(const std::string& vmaxDirName, const std::string& vmaxContentName, const JsonModelInfo& jsonModelInfo, const VmaxDecodeOptions& options = VmaxDecodeOptions()) {
+    VmaxDecodedModel decoded(vmaxContentName);
+
+    // Get this models colors from the paletteN.png 
+    std::string pngName = vmaxDirName + "/" + jsonModelInfo.paletteFile;
+    decoded.palette = read256x1PaletteFromPNG(pngName);
+    if (decoded.palette.empty()) { throw std::runtime_error("Failed to read palette from: " + pngName); }
+
+    // Read contentsN.vmaxb plist file, lzfse compressed
+    // The snapshots are walked straight from the binary plist bytes, libplist only parses files that walk refuses
+    // Scratch below lives in this threads arena and is handed back in one go on return
+    std::string modelFileName = vmaxDirName + "/" + jsonModelInfo.dataFile;
+    VmaxArena& arena = vmaxThreadArena();
+    VmaxArenaScope arenaScope(arena);
+    VmaxArenaVector<uint8_t> plistBytes{VmaxArenaAllocator<uint8_t>(arena)};
+    if (!readVmaxbBytes(modelFileName, plistBytes)) { throw std::runtime_error("Failed to read model from: " + modelFileName); }
+    VmaxArenaVector<VmaxSnapshotRecord> snapshotRecords{VmaxArenaAllocator<VmaxSnapshotRecord>(arena)};
+    plist_t plist_model_root = nullptr; // only set for the libplist fallback, owns what the records point to
+    bool walked;
+    {
+        VmaxStatTimer timer(vmaxStats().plistNanos);
+        walked = readVmaxSnapshots(plistBytes.data(), plistBytes.size(), snapshotRecords);
+    }
+    if (!walked) {
+        plist_format_t format;
+        {
+            VmaxStatTimer timer(vmaxStats().plistNanos);
+            plist_from_memory(reinterpret_cast<const char*>(plistBytes.data()), static_cast<uint32_t>(plistBytes.size()),
+                              &plist_model_root, &format);
+        }
+        if (!plist_model_root) { throw std::runtime_error("Failed to parse model from: " + modelFileName); }
+        vmaxSnapshotsFromPlist(plist_model_root, snapshotRecords);
+    }
+
+    // There will one or more snapshots in the plist file
+    // Each snapshot is a capture of a 32x32x32 voxel chunk at a point in time
+    // A chunkId is a morton code that uniquely identifies the chunk is a 8x8x8 array within 256x256x256 model volume
+    // The highest index snapshot is the current state of the model
+    // One can traverse the snapshots in reverse to get the history of the model frok inception
+    uint32_t snapshots_array_size = static_cast<uint32_t>(snapshotRecords.size());
+    decoded.snapshotCount = snapshots_array_size;
+    uint32_t snapshotEnd = snapshots_array_size;
+    if (options.snapshotLimit >= 0) {
+        snapshotEnd = static_cast<uint32_t>(std::min<int64_t>(options.snapshotLimit + 1, snapshots_array_size));
+    }
+
+    // Later snapshots of a chunk overwrite earlier ones, so only the latest one per chunk is decoded
+    // Reading just s.id.c first is cheap compared to decoding superseded voxel streams
+    // (chunk ID, snapshot index) sorted by chunk, the last entry of each chunk wins
+    VmaxArenaVector<std::pair<uint64_t, uint32_t>> latestSnapshot{VmaxArenaAllocator<std::pair<uint64_t, uint32_t>>(arena)};
+    latestSnapshot.reserve(snapshotEnd);
+    for (uint32_t i = 0; i < snapshotEnd; i++) {
+        if (!snapshotRecords[i].hasChunk) continue;
+        if (!options.decodesChunk(snapshotRecords[i].chunkID)) continue; // outside --region
+        latestSnapshot.emplace_back(static_cast<uint64_t>(snapshotRecords[i].chunkID), i);
+    }
+    std::sort(latestSnapshot.begin(), latestSnapshot.end());
+    VmaxArenaVector<uint32_t> snapshotsToDecode{VmaxArenaAllocator<uint32_t>(arena)};
+    snapshotsToDecode.reserve(latestSnapshot.size());
+    for (size_t i = 0; i < latestSnapshot.size(); i++) {
+        if (i + 1 < latestSnapshot.size() && latestSnapshot[i + 1].first == latestSnapshot[i].first) continue;
+        snapshotsToDecode.push_back(latestSnapshot[i].second);
+    }
+    std::sort(snapshotsToDecode.begin(), snapshotsToDecode.end()); // keep file order
+    decoded.snapshotsDecoded = static_cast<uint32_t>(snapshotsToDecode.size());
+    vmaxStats().snapshots += snapshots_array_size;
+    vmaxStats().snapshotsExcluded += snapshots_array_size - latestSnapshot.size();
+    vmaxStats().snapshotsSuperseded += latestSnapshot.size() - decoded.snapshotsDecoded;
+    #ifdef _DEBUG
+        std::cout << "vmaxContentName: " << vmaxContentName << std::endl;
+        std::cout << "snapshots_array_size: " << snapshots_array_size << std::endl;
+        std::cout << "snapshots decoded: " << snapshotsToDecode.size() << std::endl;
+    #endif
+
+    auto decodeStart = std::chrono::steady_clock::now();
+    size_t voxelsDecoded = 0;
+    for (uint32_t i : snapshotsToDecode) {
+        const VmaxSnapshotRecord& record = snapshotRecords[i];
+        #ifdef _DEBUG
+            std::cout << "\nChunkID: " << record.chunkID << std::endl;
+            std::cout << "TypeID: " << record.type << std::endl;
+            std::cout << "MortonCode: " << record.mortoncode << "\n" <<std::endl;
+        #endif
+
+        if (record.chunkID < 0) continue; // bad chunk
+        voxelsDecoded += decodeVoxelsInto(record.ds, record.dsLength, record.chunkID, record.mortoncode, decoded.model);
+    }
+    if (plist_model_root) plist_free(plist_model_root);
+    decoded.model.finalize();
+    vmaxStats().voxelsDecoded += voxelsDecoded;
+    vmaxStats().voxelDecodeNanos += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - decodeStart).count());
+
+    // Fold near identical shades together so they share an instancer and material
+    if (options.mergeColorsDeltaE > 0.0f) {
+        std::array<uint16_t, VmaxModel::kBucketCount> keyMap = vmaxMergeColorsKeyMap(decoded.model, decoded.palette, options.mergeColorsDeltaE);
+        uint64_t voxelsMoved = 0;
+        for (size_t b = 0; b < decoded.model.bucketKeys.size(); b++) {
+            if (keyMap[decoded.model.bucketKeys[b]] != decoded.model.bucketKeys[b]) {
+                voxelsMoved += decoded.model.bucketOffsets[b + 1] - decoded.model.bucketOffsets[b];
+            }
+        }
+        vmaxStats().mergeBucketsIn += decoded.model.bucketKeys.size();
+        decoded.model.remapBucketKeys(keyMap);
+        vmaxStats().mergeBucketsOut += decoded.model.bucketKeys.size();
+        vmaxStats().mergeVoxelsMoved += voxelsMoved;
+    }
+
+    // Parse the materials store in paletteN.settings.vmaxpsb    
+    std::string materialName = pngName.substr(0, pngName.rfind(".png")) + ".settings.vmaxpsb";
+    plist_t plist_material = readPlist(materialName, false); // decompress=false
+    decoded.materials = getVmaxMaterials(plist_material);
+    plist_free(plist_material);
+    return decoded;
+}
+
+// Hash of a block of bytes, 8 bytes at a time, good enough to notice a changed file
+// Not cryptographic, only used to key the decoded model cache
+inline uint64_t vmaxHashBytes(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint64_t kMul = 0x9E3779B97F4A7C15ull;
+    uint64_t h = seed ^ (size * kMul);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = (h ^ (word * kMul)) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    uint64_t tail = 0;
+    if (size > i) std::memcpy(&tail, data + i, size - i); // data may be null when size is 0
+    h = (h ^ (tail * kMul)) * 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 29);
+}
+
+// Key of a decoded model: contents of the .vmaxb, palette png and .settings.vmaxpsb,
+// the content name and the decode options, anything that changes decodeVmaxModel's result
+// @return key, 0 when one of the files can not be read so the model is never cached
+inline uint64_t vmaxModelCacheKey(const std::string& vmaxDirName, const std::string& vmaxContentName, const JsonModelInfo& jsonModelInfo, const VmaxDecodeOptions& options) {
+    std::string pngName = vmaxDirName + "/" + jsonModelInfo.paletteFile;
+    std::string fileNames[3] = {
+        vmaxDirName + "/" + jsonModelInfo.dataFile,
+        pngName,
+        pngName.substr(0, pngName.rfind(".png")) + ".settings.vmaxpsb"
+    };
+    uint64_t key = vmaxHashBytes(reinterpret_cast<const uint8_t*>(vmaxContentName.data()), vmaxContentName.size(), 1);
+    key = vmaxHashBytes(reinterpret_cast<const uint8_t*>(&options.snapshotLimit), sizeof(options.snapshotLimit), key);
+    key = vmaxHashBytes(reinterpret_cast<const uint8_t*>(options.chunkMask.data()), sizeof(options.chunkMask), key);
+    key = vmaxHashBytes(reinterpret_cast<const uint8_t*>(&options.mergeColorsDeltaE), sizeof(options.mergeColorsDeltaE), key);
+    for (const std::string& fileName : fileNames) {
+        VmaxSourceFile file(fileName);
+        if (!file.isOpen()) return 0;
+        key = vmaxHashBytes(file.data(), file.size(), key);
+    }
+    return key ? key : 1;
+}
+
+// On disk cache file of one decoded model, <key as 16 hex digits>.vxm
+// Little endian, the arrays are 4 byte aligned so they can be used straight from a memory map
+//   VmaxCacheHeader
+//   palette        paletteCount x VmaxRGBA
+//   bucketKeys     bucketCount x uint16, padded to 4 bytes
+//   bucketOffsets  (bucketCount + 1) x uint32
+//   positions      positionCount x uint32, packed see packVoxelPosition()
+//   materials      8 x { uint32 name length, name, 4 x double, 3 x uint8 flags }
+struct VmaxCacheHeader {
+    char magic[4];          // "VXMC"
+    uint32_t version;
+    uint64_t key;           // vmaxModelCacheKey(), guards against renamed files
+    uint32_t paletteCount;
+    uint32_t bucketCount;
+    uint32_t positionCount;
+    uint32_t snapshotCount;
+    uint32_t snapshotsDecoded;
+    uint32_t reserved;
+};
+constexpr uint32_t kVmaxCacheVersion = 1;
+
+inline size_t vmaxCacheAlign4(size_t size) {
+    return (size + 3) & ~size_t(3);
+}
+
+inline std::string vmaxCacheFileName(const std::string& cacheDirName, uint64_t key) {
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(cacheDirName) / (std::string(hex) + ".vxm")).string();
+}
+
+// Material table as stored in .vxm and .vxc files
+//   8 x { uint32 name length, name, 4 x double, 3 x uint8 flags }
+inline void appendVmaxMaterials(std::vector<uint8_t>& bytes, const std::array<VmaxMaterial, 8>& materials) {
+    auto append = [&](const void* data, size_t size) {
+        const uint8_t* from = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), from, from + size);
+    };
+    for (const VmaxMaterial& material : materials) {
+        uint32_t nameLength = static_cast<uint32_t>(material.materialName.size());
+        append(&nameLength, sizeof(nameLength));
+        append(material.materialName.data(), nameLength);
+        double values[4] = {material.transmission, material.roughness, material.metalness, material.emission};
+        append(values, sizeof(values));
+        uint8_t flags[3] = {material.enableShadows, material.dielectric, material.volumetric};
+        append(flags, sizeof(flags));
+    }
+}
+
+// @param at: offset of the table, moved past it
+// @return false if the table runs past size
+inline bool readVmaxMaterials(const uint8_t* data, size_t size, size_t& at, std::array<VmaxMaterial, 8>& outMaterials) {
+    for (VmaxMaterial& material : outMaterials) {
+        uint32_t nameLength = 0;
+        if (at + sizeof(nameLength) > size) return false;
+        std::memcpy(&nameLength, data + at, sizeof(nameLength));
+        at += sizeof(nameLength);
+        if (at + nameLength + 4 * sizeof(double) + 3 > size) return false;
+        material.materialName.assign(reinterpret_cast<const char*>(data + at), nameLength);
+        at += nameLength;
+        double values[4];
+        std::memcpy(values, data + at, sizeof(values));
+        at += sizeof(values);
+        material.transmission = values[0];
+        material.roughness = values[1];
+        material.metalness = values[2];
+        material.emission = values[3];
+        material.enableShadows = data[at] != 0;
+        material.dielectric = data[at + 1] != 0;
+        material.volumetric = data[at + 2] != 0;
+        at += 3;
+    }
+    return true;
+}
+
+// Written to a temporary file then renamed so a reader never sees a half written file
+// @return true on success
+inline bool writeVmaxFileAtomically(const std::string& fileName, const std::vector<uint8_t>& bytes) {
+    std::error_code error;
+    // Unique across threads and processes sharing a --cachedir, even on other hosts
+    static std::atomic<uint64_t> tempCounter{0};
+#if defined(_WIN32)
+    uint64_t pid = GetCurrentProcessId();
+#else
+    uint64_t pid = static_cast<uint64_t>(getpid());
+#endif
+    std::string tempName = fileName + ".tmp" + std::to_string(pid) + "_" + std::to_string(tempCounter++) + "_" +
+                           std::to_string(std::random_device()());
+    {
+        std::ofstream out(tempName, std::ios::binary);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out) return false;
+    }
+    std::filesystem::rename(tempName, fileName, error);
+    if (error) {
+        std::filesystem::remove(tempName, error);
+        return false;
+    }
+    return true;
+}
+
+// Write a decoded model to the cache directory, written to a temporary file then renamed
+// so a reader never sees a half written file
+// @return true on success, a failed write only costs a decode next time
+inline bool writeVmaxModelCache(const std::string& cacheDirName, uint64_t key, const VmaxDecodedModel& decoded) {
+    const VmaxModel& model = decoded.model;
+    std::vector<uint8_t> bytes;
+    auto append = [&](const void* data, size_t size) {
+        const uint8_t* from = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), from, from + size);
+    };
+    VmaxCacheHeader header = {};
+    std::memcpy(header.magic, "VXMC", 4);
+    header.version = kVmaxCacheVersion;
+    header.key = key;
+    header.paletteCount = static_cast<uint32_t>(decoded.palette.size());
+    header.bucketCount = static_cast<uint32_t>(model.bucketKeys.size());
+    header.positionCount = static_cast<uint32_t>(model.positions.size());
+    header.snapshotCount = decoded.snapshotCount;
+    header.snapshotsDecoded = decoded.snapshotsDecoded;
+    append(&header, sizeof(header));
+    append(decoded.palette.data(), decoded.palette.size() * sizeof(VmaxRGBA));
+    append(model.bucketKeys.data(), model.bucketKeys.size() * sizeof(uint16_t));
+    bytes.resize(vmaxCacheAlign4(bytes.size()), 0);
+    // bucketCount + 1 offsets, an empty model has no bucketOffsets but the reader still expects the leading 0
+    if (model.bucketOffsets.empty()) {
+        uint32_t zero = 0;
+        append(&zero, sizeof(zero));
+    } else {
+        append(model.bucketOffsets.data(), model.bucketOffsets.size() * sizeof(uint32_t));
+    }
+    append(model.positions.data(), model.positions.size() * sizeof(uint32_t));
+    appendVmaxMaterials(bytes, decoded.materials);
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirName, error);
+    return writeVmaxFileAtomically(vmaxCacheFileName(cacheDirName, key), bytes);
+}
+
+// Load a decoded model from the cache directory
+// @return the model, nullptr when there is no valid cache file for this key
+inline std::shared_ptr<VmaxDecodedModel> readVmaxModelCache(const std::string& cacheDirName, uint64_t key, const std::string& vmaxContentName) {
+    VmaxMappedFile file(vmaxCacheFileName(cacheDirName, key));
+    if (!file.isOpen() || file.size() < sizeof(VmaxCacheHeader)) return nullptr;
+    const uint8_t* data = file.data();
+    const size_t size = file.size();
+    VmaxCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, "VXMC", 4) != 0 || header.version != kVmaxCacheVersion || header.key != key) return nullptr;
+
+    size_t at = sizeof(header);
+    const uint8_t* palette = data + at;
+    at += size_t(header.paletteCount) * sizeof(VmaxRGBA);
+    const uint8_t* keys = data + at;
+    at = vmaxCacheAlign4(at + size_t(header.bucketCount) * sizeof(uint16_t));
+    const uint8_t* offsets = data + at;
+    at += (size_t(header.bucketCount) + 1) * sizeof(uint32_t);
+    const uint8_t* positions = data + at;
+    at += size_t(header.positionCount) * sizeof(uint32_t);
+    if (at > size) return nullptr;
+
+    // A truncated or corrupt file must not give buckets that run backwards or overlap
+    uint32_t previousOffset = 0;
+    for (size_t b = 0; b <= header.bucketCount; b++) {
+        uint32_t offset;
+        std::memcpy(&offset, offsets + b * sizeof(uint32_t), sizeof(offset));
+        if ((b == 0 && offset != 0) || offset < previousOffset || offset > header.positionCount) return nullptr;
+        previousOffset = offset;
+    }
+    if (previousOffset != header.positionCount) return nullptr;
+    for (size_t b = 0; b < header.bucketCount; b++) {
+        uint16_t bucketKey, previousKey = 0;
+        std::memcpy(&bucketKey, keys + b * sizeof(uint16_t), sizeof(bucketKey));
+        if (b > 0) std::memcpy(&previousKey, keys + (b - 1) * sizeof(uint16_t), sizeof(previousKey));
+        if (bucketKey >= VmaxModel::kBucketCount || (b > 0 && bucketKey <= previousKey)) return nullptr;
+    }
+
+    auto decoded = std::make_shared<VmaxDecodedModel>(vmaxContentName);
+    decoded->snapshotCount = header.snapshotCount;
+    decoded->snapshotsDecoded = header.snapshotsDecoded;
+    decoded->palette.resize(header.paletteCount);
+    if (header.paletteCount) std::memcpy(decoded->palette.data(), palette, size_t(header.paletteCount) * sizeof(VmaxRGBA));
+    decoded->model.assignBuckets(reinterpret_cast<const uint32_t*>(positions), header.positionCount,
+                                 reinterpret_cast<const uint16_t*>(keys),
+                                 reinterpret_cast<const uint32_t*>(offsets), header.bucketCount);
+    if (!readVmaxMaterials(data, size, at, decoded->materials)) return nullptr;
+    return decoded;
+}
+
+// Compact voxel file of one decoded model, written by --vxc next to the .bsz
+// Loads without LZFSE, plist or ds decoding, and a reader can pick the chunks it wants
+// Little endian, sections are 8 byte aligned so the file can be used straight from a memory map
+//   VmaxChunkFileHeader
+//   palette        paletteCount x VmaxRGBA
+//   directory      chunkCount x VmaxChunkFileEntry, ascending chunk morton id
+//   materials      see appendVmaxMaterials()
+//   payloads       one per occupied chunk, at entry.offset
+// A payload holds the 32x32x32 voxels of a chunk in local morton order, in whichever encoding is smaller
+//   Rle      runs of { uint16 length - 1, uint8 material, uint8 color }, color 0 is a run of empty voxels,
+//            the runs cover all 32768 voxels
+//   Bitmask  32768 bit occupancy as 512 uint64, then { uint8 material, uint8 color } per set bit
+struct VmaxChunkFileHeader {
+    char magic[4];          // "VXCF"
+    uint32_t version;
+    uint32_t chunkCount;
+    uint32_t paletteCount;
+    uint32_t snapshotCount;
+    uint32_t snapshotsDecoded;
+    uint64_t voxelCount;
+    uint64_t directoryOffset;
+    uint64_t materialsOffset;
+};
+constexpr uint32_t kVmaxChunkFileVersion = 1;
+
+struct VmaxChunkFileEntry {
+    enum Encoding : uint8_t { Rle = 1, Bitmask = 2 };
+    uint16_t chunk;         // 8x8x8 chunk morton id, same as a snapshot's s.id.c
+    uint8_t encoding;
+    uint8_t reserved;
+    uint32_t voxelCount;
+    uint64_t offset;        // from the start of the file
+    uint64_t size;
+};
+
+inline size_t vmaxAlign8(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+// Write a decoded model as a .vxc
+// @return true on success
+inline bool writeVmaxChunkFile(const std::string& fileName, const VmaxDecodedModel& decoded) {
+    constexpr uint32_t kChunkVoxels = 32 * 32 * 32;
+    const VmaxModel& model = decoded.model;
+
+    // Voxels grouped by chunk with a counting sort, each as local morton | bucket key << 15
+    VmaxArena& arena = vmaxThreadArena();
+    VmaxArenaScope arenaScope(arena);
+    std::vector<uint32_t> chunkStarts(513, 0);
+    VmaxArenaVector<uint32_t> sorted(model.positions.size(), 0, VmaxArenaAllocator<uint32_t>(arena));
+    auto forEachVoxel = [&](auto&& visit) {
+        for (size_t b = 0; b < model.bucketKeys.size(); b++) {
+            for (uint32_t i = model.bucketOffsets[b]; i < model.bucketOffsets[b + 1]; i++) {
+                uint32_t x, y, z;
+                unpackVoxelPosition(model.positions[i], x, y, z);
+                visit(encodeMorton3D(x >> 5, y >> 5, z >> 5), encodeMorton3D(x & 31, y & 31, z & 31) | (uint32_t(model.bucketKeys[b]) << 15));
+            }
+        }
+    };
+    forEachVoxel([&](uint32_t chunk, uint32_t) { chunkStarts[chunk + 1]++; });
+    for (size_t chunk = 0; chunk < 512; chunk++) chunkStarts[chunk + 1] += chunkStarts[chunk];
+    std::vector<uint32_t> cursor(chunkStarts.begin(), chunkStarts.end() - 1);
+    forEachVoxel([&](uint32_t chunk, uint32_t voxel) { sorted[cursor[chunk]++] = voxel; });
+
+    std::vector<uint8_t> bytes;
+    auto append = [&](const void* data, size_t size) {
+        const uint8_t* from = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), from, from + size);
+    };
+    std::vector<VmaxChunkFileEntry> directory;
+    for (uint32_t chunk = 0; chunk < 512; chunk++) {
+        if (chunkStarts[chunk] != chunkStarts[chunk + 1]) directory.push_back(VmaxChunkFileEntry{static_cast<uint16_t>(chunk), 0, 0, 0, 0, 0});
+    }
+    VmaxChunkFileHeader header = {};
+    std::memcpy(header.magic, "VXCF", 4);
+    header.version = kVmaxChunkFileVersion;
+    header.chunkCount = static_cast<uint32_t>(directory.size());
+    header.paletteCount = static_cast<uint32_t>(decoded.palette.size());
+    header.snapshotCount = decoded.snapshotCount;
+    header.snapshotsDecoded = decoded.snapshotsDecoded;
+    header.voxelCount = model.positions.size();
+    append(&header, sizeof(header));
+    append(decoded.palette.data(), decoded.palette.size() * sizeof(VmaxRGBA));
+    bytes.resize(vmaxAlign8(bytes.size()), 0);
+    header.directoryOffset = bytes.size();
+    bytes.resize(bytes.size() + directory.size() * sizeof(VmaxChunkFileEntry), 0); // filled in once the payloads are known
+    header.materialsOffset = bytes.size();
+    appendVmaxMaterials(bytes, decoded.materials);
+
+    // Dense material << 8 | color per voxel of the chunk being written, 0 is empty
+    VmaxArenaVector<uint16_t> slots(kChunkVoxels, 0, VmaxArenaAllocator<uint16_t>(arena));
+    for (VmaxChunkFileEntry& entry : directory) {
+        uint32_t voxelCount = 0;
+        for (uint32_t i = chunkStarts[entry.chunk]; i < chunkStarts[entry.chunk + 1]; i++) {
+            uint16_t& slot = slots[sorted[i] & (kChunkVoxels - 1)];
+            if (slot == 0) voxelCount++; // a voxel added twice is kept once
+            slot = static_cast<uint16_t>(sorted[i] >> 15);
+        }
+        size_t runCount = 0;
+        for (uint32_t i = 0; i < kChunkVoxels; i++) {
+            if (i == 0 || slots[i] != slots[i - 1]) runCount++;
+        }
+        bytes.resize(vmaxAlign8(bytes.size()), 0);
+        entry.offset = bytes.size();
+        entry.voxelCount = voxelCount;
+        if (runCount * 4 <= kChunkVoxels / 8 + size_t(voxelCount) * 2) {
+            entry.encoding = VmaxChunkFileEntry::Rle;
+            for (uint32_t i = 0; i < kChunkVoxels;) {
+                uint32_t runEnd = i + 1;
+                while (runEnd < kChunkVoxels && slots[runEnd] == slots[i]) runEnd++;
+                uint8_t run[4] = {static_cast<uint8_t>((runEnd - i - 1) & 0xff), static_cast<uint8_t>((runEnd - i - 1) >> 8),
+                                  static_cast<uint8_t>(slots[i] >> 8), static_cast<uint8_t>(slots[i] & 0xff)};
+                append(run, sizeof(run));
+                i = runEnd;
+            }
+        } else {
+            entry.encoding = VmaxChunkFileEntry::Bitmask;
+            std::vector<uint64_t> mask(kChunkVoxels / 64, 0);
+            for (uint32_t i = 0; i < kChunkVoxels; i++) {
+                if (slots[i]) mask[i >> 6] |= uint64_t(1) << (i & 63);
+            }
+            append(mask.data(), mask.size() * sizeof(uint64_t));
+            for (uint32_t i = 0; i < kChunkVoxels; i++) {
+                if (!slots[i]) continue;
+                uint8_t pair[2] = {static_cast<uint8_t>(slots[i] >> 8), static_cast<uint8_t>(slots[i] & 0xff)};
+                append(pair, sizeof(pair));
+            }
+        }
+        entry.size = bytes.size() - entry.offset;
+        for (uint32_t i = chunkStarts[entry.chunk]; i < chunkStarts[entry.chunk + 1]; i++) {
+            slots[sorted[i] & (kChunkVoxels - 1)] = 0;
+        }
+    }
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    if (!directory.empty()) { // an empty model has no chunks, directory.data() may be null
+        std::memcpy(bytes.data() + header.directoryOffset, directory.data(), directory.size() * sizeof(VmaxChunkFileEntry));
+    }
+    return writeVmaxFileAtomically(fileName, bytes);
+}
+
+// Read side of a .vxc, memory mapped so only the chunks that are loaded are ever paged in
+class VmaxChunkFile {
+public:
+    explicit VmaxChunkFile(const std::string& fileName) : file(fileName) {
+        valid = file.isOpen() && readDirectory();
+    }
+
+    VmaxChunkFile(const VmaxChunkFile&) = delete;
+    VmaxChunkFile& operator=(const VmaxChunkFile&) = delete;
+
+    // @return false if the file is missing, from another version or malformed
+    bool isOpen() const { return valid; }
+    const VmaxChunkFileHeader& getHeader() const { return header; }
+    const std::vector<VmaxChunkFileEntry>& chunks() const { return directory; }
+    const std::vector<VmaxRGBA>& getPalette() const { return palette; }
+    const std::array<VmaxMaterial, 8>& getMaterials() const { return materials; }
+
+    // Index in chunks() of a chunk morton id, -1 when the chunk is empty
+    int findChunk(uint32_t chunk) const {
+        auto found = std::lower_bound(directory.begin(), directory.end(), chunk,
+            [](const VmaxChunkFileEntry& entry, uint32_t id) { return entry.chunk < id; });
+        if (found == directory.end() || found->chunk != chunk) return -1;
+        return static_cast<int>(found - directory.begin());
+    }
+
+    // Add the voxels of one chunk to a model, call model.finalize() after the last chunk
+    // @return false if the payload is malformed, voxels added before the error stay in the model
+    bool addChunkVoxels(size_t index, VmaxModel& model) const {
+        constexpr uint32_t kChunkVoxels = 32 * 32 * 32;
+        if (index >= directory.size()) return false;
+        const VmaxChunkFileEntry& entry = directory[index];
+        const uint8_t* payload = file.data() + entry.offset;
+        uint32_t chunkX, chunkY, chunkZ;
+        decodeMorton3DOptimized(entry.chunk, chunkX, chunkY, chunkZ);
+        chunkX *= 32; chunkY *= 32; chunkZ *= 32;
+
+        if (entry.encoding == VmaxChunkFileEntry::Rle) {
+            constexpr size_t blockSize = 256;
+            uint8_t blockX[blockSize], blockY[blockSize], blockZ[blockSize];
+            uint32_t cursor = 0;
+            for (size_t at = 0; at + 4 <= entry.size && cursor < kChunkVoxels; at += 4) {
+                uint32_t length = (payload[at] | (payload[at + 1] << 8)) + 1u;
+                uint8_t material = payload[at + 2];
+                uint8_t color = payload[at + 3];
+                if (length > kChunkVoxels - cursor) return false;
+                for (uint32_t blockStart = 0; color != 0 && blockStart < length; blockStart += blockSize) {
+                    size_t blockCount = std::min<size_t>(blockSize, length - blockStart);
+                    decodeMorton3DBatch(cursor + blockStart, blockCount, blockX, blockY, blockZ);
+                    for (size_t i = 0; i < blockCount; i++) {
+                        model.addVoxel(chunkX + blockX[i], chunkY + blockY[i], chunkZ + blockZ[i], material, color);
+                    }
+                }
+                cursor += length;
+            }
+            return cursor == kChunkVoxels;
+        }
+        if (entry.encoding == VmaxChunkFileEntry::Bitmask) {
+            constexpr size_t maskBytes = kChunkVoxels / 8;
+            if (entry.size < maskBytes + size_t(entry.voxelCount) * 2) return false;
+            const uint8_t* pair = payload + maskBytes;
+            uint32_t visited = 0;
+            for (uint32_t word = 0; word < kChunkVoxels / 64; word++) {
+                uint64_t bits;
+                std::memcpy(&bits, payload + word * 8, sizeof(bits));
+                while (bits) {
+                    if (visited++ == entry.voxelCount) return false;
+#if defined(_MSC_VER)
+                    unsigned long bit;
+                    _BitScanForward64(&bit, bits);
+#else
+                    int bit = __builtin_ctzll(bits);
+#endif
+                    bits &= bits - 1;
+                    uint32_t x, y, z;
+                    decodeMorton3DOptimized(word * 64 + static_cast<uint32_t>(bit), x, y, z);
+                    model.addVoxel(chunkX + x, chunkY + y, chunkZ + z, pair[0], pair[1]);
+                    pair += 2;
+                }
+            }
+            return visited == entry.voxelCount;
+        }
+        return false;
+    }
+
+    // Decoded model of the chunks wantChunk(cx, cy, cz) accepts, chunk coordinates 0-7
+    // @return nullptr if a payload is malformed
+    template <typename WantChunk>
+    std::shared_ptr<VmaxDecodedModel> load(const std::string& vmaxContentName, WantChunk&& wantChunk) const {
+        if (!valid) return nullptr;
+        auto decoded = std::make_shared<VmaxDecodedModel>(vmaxContentName);
+        decoded->palette = palette;
+        decoded->materials = materials;
+        decoded->snapshotCount = header.snapshotCount;
+        decoded->snapshotsDecoded = header.snapshotsDecoded;
+        for (size_t index = 0; index < directory.size(); index++) {
+            uint32_t cx, cy, cz;
+            decodeMorton3DOptimized(directory[index].chunk, cx, cy, cz);
+            if (!wantChunk(cx, cy, cz)) continue;
+            if (!addChunkVoxels(index, decoded->model)) return nullptr;
+        }
+        decoded->model.finalize();
+        return decoded;
+    }
+
+    // Whole model
+    std::shared_ptr<VmaxDecodedModel> load(const std::string& vmaxContentName) const {
+        return load(vmaxContentName, [](uint32_t, uint32_t, uint32_t) { return true; });
+    }
+
+private:
+    bool readDirectory() {
+        const uint8_t* data = file.data();
+        size_t size = file.size();
+        if (size < sizeof(header)) return false;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, "VXCF", 4) != 0 || header.version != kVmaxChunkFileVersion) return false;
+        if (header.chunkCount > 512 || header.paletteCount > 256) return false;
+        size_t paletteEnd = sizeof(header) + size_t(header.paletteCount) * sizeof(VmaxRGBA);
+        if (header.directoryOffset < paletteEnd || header.directoryOffset > size ||
+            (size - header.directoryOffset) / sizeof(VmaxChunkFileEntry) < header.chunkCount) return false;
+        palette.resize(header.paletteCount);
+        if (!palette.empty()) std::memcpy(palette.data(), data + sizeof(header), palette.size() * sizeof(VmaxRGBA));
+        directory.resize(header.chunkCount);
+        if (!directory.empty()) {
+            std::memcpy(directory.data(), data + header.directoryOffset, directory.size() * sizeof(VmaxChunkFileEntry));
+        }
+        for (size_t i = 0; i < directory.size(); i++) {
+            const VmaxChunkFileEntry& entry = directory[i];
+            if (entry.chunk >= 512 || (i > 0 && entry.chunk <= directory[i - 1].chunk)) return false;
+            if (entry.offset > size || entry.size > size - entry.offset) return false;
+        }
+        size_t at = static_cast<size_t>(header.materialsOffset);
+        return header.materialsOffset <= size && readVmaxMaterials(data, size, at, materials);
+    }
+
+    VmaxSourceFile file;
+    bool valid = false;
+    VmaxChunkFileHeader header = {};
+    std::vector<VmaxChunkFileEntry> directory;
+    std::vector<VmaxRGBA> palette;
+    std::array<VmaxMaterial, 8> materials;
+};
+
+// Decoded models by content, shared by every conversion in this process (--watchdir re-exports)
+// and optionally backed by a directory of .vxm files shared across runs
+// Unchanged models cost one hash of their three files instead of an LZFSE and plist decode
+// Thread safe, decode runs outside the lock
+class VmaxModelCache {
+public:
+    // @param maxEntries: models kept in memory, oldest are dropped first
+    // @param maxBytes: memory the kept models may use, see decodedBytes(), oldest are dropped first
+    explicit VmaxModelCache(size_t maxEntries = 256, size_t maxBytes = size_t(1) << 30) : maxMemoryEntries(maxEntries), maxMemoryBytes(maxBytes) {
+    }
+
+    // Heap memory of a decoded model, a full 256^3 model is about 64MB of positions plus 2MB of bricks
+    static size_t decodedBytes(const VmaxDecodedModel& decoded) {
+        const VmaxModel& model = decoded.model;
+        return model.positions.size() * sizeof(uint32_t) + model.bucketKeys.size() * sizeof(uint16_t) +
+               model.bucketOffsets.size() * sizeof(uint32_t) + model.occupancy.memoryBytes() +
+               decoded.palette.size() * sizeof(VmaxRGBA) + sizeof(VmaxDecodedModel);
+    }
+
+    // Directory for .vxm files, empty to only cache in memory
+    void setCacheDir(const std::string& dirName) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cacheDirName = dirName;
+    }
+
+    // Models kept in memory from now on, 0 keeps none, oldest are dropped right away if over
+    void setMaxEntries(size_t maxEntries) {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxMemoryEntries = maxEntries;
+        evictOverLimits();
+    }
+
+    // Memory the models kept in memory may use from now on, see decodedBytes()
+    void setMaxBytes(size_t maxBytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxMemoryBytes = maxBytes;
+        evictOverLimits();
+    }
+
+    // Same as decodeVmaxModel() but served from the cache when the files are unchanged
+    // @param outKey: optional, gets the vmaxModelCacheKey() of the model
+    std::shared_ptr<const VmaxDecodedModel> decode(const std::string& vmaxDirName, const std::string& vmaxContentName, const JsonModelInfo& jsonModelInfo, const VmaxDecodeOptions& options = VmaxDecodeOptions(), uint64_t* outKey = nullptr) {
+        uint64_t key = vmaxModelCacheKey(vmaxDirName, vmaxContentName, jsonModelInfo, options);
+        if (outKey) *outKey = key;
+        return decodeKeyed(key, vmaxDirName, vmaxContentName, jsonModelInfo, options);
+    }
+
+    // decode() with a key the caller already computed with vmaxModelCacheKey()
+    std::shared_ptr<const VmaxDecodedModel> decodeKeyed(uint64_t key, const std::string& vmaxDirName, const std::string& vmaxContentName, const JsonModelInfo& jsonModelInfo, const VmaxDecodeOptions& options = VmaxDecodeOptions()) {
+        std::string dirName;
+        if (key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = memoryEntries.find(key);
+            if (found != memoryEntries.end()) {
+                memoryHits++;
+                vmaxStats().modelsCached++;
+                return found->second;
+            }
+            dirName = cacheDirName;
+        }
+
+        std::shared_ptr<const VmaxDecodedModel> decoded;
+        bool fromDisk = false;
+        if (key && !dirName.empty()) {
+            decoded = readVmaxModelCache(dirName, key, vmaxContentName);
+            fromDisk = decoded != nullptr;
+        }
+        if (!decoded) {
+            auto fresh = std::make_shared<VmaxDecodedModel>(decodeVmaxModel(vmaxDirName, vmaxContentName, jsonModelInfo, options));
+            if (key && !dirName.empty()) {
+                writeVmaxModelCache(dirName, key, *fresh);
+            }
+            decoded = fresh;
+        }
+        if (!key) {
+            vmaxStats().modelsDecoded++;
+            return decoded;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fromDisk) diskHits++; else misses++;
+        if (fromDisk) vmaxStats().modelsCached++; else vmaxStats().modelsDecoded++;
+        if (memoryEntries.emplace(key, decoded).second) {
+            memoryOrder.push_back(key);
+            memoryBytes += decodedBytes(*decoded);
+            evictOverLimits();
+        }
+        return decoded;
+    }
+
+    // Counters since start, misses are full decodes
+    void getCounts(size_t& outMemoryHits, size_t& outDiskHits, size_t& outMisses) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        outMemoryHits = memoryHits;
+        outDiskHits = diskHits;
+        outMisses = misses;
+    }
+
+private:
+    // Drop the oldest models until both limits hold, callers hold the lock
+    // Models still used by a conversion stay alive through its shared_ptr
+    void evictOverLimits() {
+        while (!memoryOrder.empty() && (memoryOrder.size() > maxMemoryEntries || memoryBytes > maxMemoryBytes)) {
+            auto oldest = memoryEntries.find(memoryOrder.front());
+            memoryBytes -= decodedBytes(*oldest->second);
+            memoryEntries.erase(oldest);
+            memoryOrder.pop_front();
+        }
+    }
+
+    mutable std::mutex mutex;
+    std::string cacheDirName;
+    size_t maxMemoryEntries;
+    size_t maxMemoryBytes;
+    size_t memoryBytes = 0; // decodedBytes() of every kept model
+    std::unordered_map<uint64_t, std::shared_ptr<const VmaxDecodedModel>> memoryEntries;
+    std::deque<uint64_t> memoryOrder;
+    size_t memoryHits = 0;
+    size_t diskHits = 0;
+    size_t misses = 0;
+};
+
 /*
 MIT License
 
@@ -0,0 +1,454 @@
+// vmaxbench.cpp - Benchmarks for the hot paths of the .vmax to Bella conversion
+//
+// Builds vmaxtui.cpp with its own DL_main so the timed code is exactly what the converter runs
+// Synthetic voxel streams at several fill ratios are timed through each stage separately:
+//   decodeMorton3DOptimized / decodeMorton3DBatch, decodeVoxels, decodeVoxelsInto,
+//   readPlist, readVmaxSnapshots and vmaxVoxelInfo on a generated lzfse compressed plist, addModelToScene
+// Real .vmax directories given with --input go through readPlist, decodeVmaxModel and addModelToScene
+//
+// make bench BENCH_ARGS="--input foo.vmax --baseline bench.json"
+// Each stage reports the best of --reps runs as ns per voxel and MB/s of input, plus the
+// process peak RSS after the stage. --save-baseline writes the results as json,
+// --baseline compares against such a file and flags stages that got slower
+
+#define VMAXTUI_NO_MAIN
+#include "vmaxtui.cpp"
+
+#ifdef _WIN32
+#include <psapi.h> // For GetProcessMemoryInfo
+#else
+#include <sys/resource.h> // For getrusage
+#endif
+
+namespace {
+
+unsigned benchReps = 5;
+
+// Peak resident set size of this process in MB
+double peakRssMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / 1e6;
+    }
+    return 0.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1e6; // bytes on macOS
+#else
+    return usage.ru_maxrss / 1e3; // kilobytes on Linux
+#endif
+#endif
+}
+
+struct BenchResult {
+    std::string name;
+    double nanos = 0;       // best run
+    uint64_t voxels = 0;    // voxels per run, ns/voxel is nanos / voxels
+    uint64_t bytes = 0;     // input bytes per run, MB/s is bytes / nanos
+    double peakRss = 0;     // MB after the stage
+};
+std::vector<BenchResult> benchResults;
+
+// Keep and print the result of one stage
+BenchResult& recordBench(const std::string& name, double nanos, uint64_t voxels, uint64_t bytes) {
+    benchResults.push_back(BenchResult{name, nanos, voxels, bytes, peakRssMB()});
+    const BenchResult& result = benchResults.back();
+    char line[256];
+    snprintf(line, sizeof(line), "%-40s %10.2f ms  %9.2f ns/voxel  %9.1f MB/s  %8.1f MB peak",
+             name.c_str(), nanos / 1e6,
+             voxels ? nanos / voxels : 0.0,
+             bytes && nanos > 0 ? bytes / (nanos / 1e9) / 1e6 : 0.0,
+             result.peakRss);
+    std::cout << line << std::endl;
+    return benchResults.back();
+}
+
+// Time fn() benchReps times and keep the fastest run, fn is expected to do the same work every time
+template <typename Fn>
+BenchResult& bench(const std::string& name, uint64_t voxels, uint64_t bytes, Fn&& fn) {
+    double best = 0;
+    for (unsigned rep = 0; rep < benchReps; rep++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double nanos = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        if (rep == 0 || nanos < best) best = nanos;
+    }
+    return recordBench(name, best, voxels, bytes);
+}
+
+// Keeps the optimizer from dropping the work being timed
+volatile uint64_t benchSink = 0;
+
+// Small deterministic generator so runs and machines see the same streams
+struct BenchRandom {
+    uint64_t state;
+    explicit BenchRandom(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<uint32_t>(state >> 32);
+    }
+};
+
+// One 32x32x32 chunk worth of [material, color] pairs, fill is the fraction of non empty voxels
+std::vector<uint8_t> syntheticDsStream(double fill, uint64_t seed) {
+    BenchRandom random(seed);
+    std::vector<uint8_t> ds(32 * 32 * 32 * 2, 0);
+    uint32_t threshold = static_cast<uint32_t>(fill * 4294967295.0);
+    for (size_t i = 0; i < 32 * 32 * 32; i++) {
+        if (fill >= 1.0 || random.next() < threshold) {
+            uint32_t value = random.next();
+            ds[i * 2] = static_cast<uint8_t>(value % 8);               // material 0-7
+            ds[i * 2 + 1] = static_cast<uint8_t>(1 + (value >> 8) % 16); // a handful of colors, like a real palette
+        }
+    }
+    return ds;
+}
+
+// Generated contentsN.vmaxb, one snapshot per chunk, lzfse compressed like Vmax writes them
+// @return false if the file could not be written
+bool writeSyntheticVmaxb(const std::string& fileName, const std::vector<std::vector<uint8_t>>& chunkStreams) {
+    plist_t root = plist_new_dict();
+    plist_t snapshots = plist_new_array();
+    for (size_t chunk = 0; chunk < chunkStreams.size(); chunk++) {
+        plist_t id = plist_new_dict();
+        plist_dict_set_item(id, "c", plist_new_uint(chunk));
+        plist_dict_set_item(id, "s", plist_new_uint(0));
+        plist_dict_set_item(id, "t", plist_new_uint(0));
+        plist_t min = plist_new_array();
+        for (int i = 0; i < 4; i++) plist_array_append_item(min, plist_new_uint(0));
+        plist_t st = plist_new_dict();
+        plist_dict_set_item(st, "min", min);
+        plist_t s = plist_new_dict();
+        plist_dict_set_item(s, "id", id);
+        plist_dict_set_item(s, "st", st);
+        plist_dict_set_item(s, "ds", plist_new_data(reinterpret_cast<const char*>(chunkStreams[chunk].data()), chunkStreams[chunk].size()));
+        plist_t snapshot = plist_new_dict();
+        plist_dict_set_item(snapshot, "s", s);
+        plist_array_append_item(snapshots, snapshot);
+    }
+    plist_dict_set_item(root, "snapshots", snapshots);
+    char* binary = nullptr;
+    uint32_t binarySize = 0;
+    plist_to_bin(root, &binary, &binarySize);
+    plist_free(root);
+    if (!binary) return false;
+
+    std::vector<uint8_t> compressed(binarySize + 4096);
+    std::vector<uint8_t> scratch(lzfse_encode_scratch_size());
+    size_t compressedSize = lzfse_encode_buffer(compressed.data(), compressed.size(),
+                                                reinterpret_cast<const uint8_t*>(binary), binarySize, scratch.data());
+    plist_mem_free(binary);
+    if (compressedSize == 0) return false;
+    std::ofstream out(fileName, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(compressed.data()), compressedSize);
+    return static_cast<bool>(out);
+}
+
+// Greyscale palette and plain diffuse materials, enough for addModelToScene to pick material types
+std::vector<VmaxRGBA> syntheticPalette() {
+    std::vector<VmaxRGBA> palette(256);
+    for (int i = 0; i < 256; i++) {
+        palette[i] = VmaxRGBA{static_cast<uint8_t>(i), static_cast<uint8_t>(i), static_cast<uint8_t>(i), 255};
+    }
+    return palette;
+}
+
+std::array<VmaxMaterial, 8> syntheticMaterials() {
+    std::array<VmaxMaterial, 8> materials;
+    for (int i = 0; i < 8; i++) {
+        materials[i] = VmaxMaterial{"material" + std::to_string(i), 0.0, 0.5, 0.0, 0.0, true, false, false};
+    }
+    return materials;
+}
+
+// addModelToScene into a fresh scene, defs and essentials are set up outside the timer
+double timeAddModelToScene(const VmaxModel& model, const std::vector<VmaxRGBA>& palette, const std::array<VmaxMaterial, 8>& materials, const ConvertOptions& options) {
+    dl::bella_sdk::Scene belScene;
+    belScene.loadDefs();
+    essentialsToScene(belScene);
+    auto belWorld = belScene.world(true);
+    auto start = std::chrono::steady_clock::now();
+    addModelToScene(belScene, belWorld, model, palette, materials, options);
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+// Same as bench() for addModelToScene, only the call itself is timed
+BenchResult& benchAddModel(const std::string& name, const VmaxModel& model, const std::vector<VmaxRGBA>& palette, const std::array<VmaxMaterial, 8>& materials, const ConvertOptions& options) {
+    double best = 0;
+    for (unsigned rep = 0; rep < benchReps; rep++) {
+        double nanos = timeAddModelToScene(model, palette, materials, options);
+        if (rep == 0 || nanos < best) best = nanos;
+    }
+    return recordBench(name, best, model.positions.size(), 0);
+}
+
+void benchMorton() {
+    const uint32_t count = 32 * 32 * 32;
+    const uint32_t rounds = 64;
+    bench("decodeMorton3DOptimized", uint64_t(count) * rounds, 0, [&] {
+        uint64_t sum = 0;
+        for (uint32_t round = 0; round < rounds; round++) {
+            for (uint32_t morton = 0; morton < count; morton++) {
+                uint32_t x, y, z;
+                decodeMorton3DOptimized(morton + round, x, y, z);
+                sum += x + y + z;
+            }
+        }
+        benchSink += sum;
+    });
+    std::vector<uint8_t> x(count), y(count), z(count);
+    bench("decodeMorton3DBatch", uint64_t(count) * rounds, 0, [&] {
+        uint64_t sum = 0;
+        for (uint32_t round = 0; round < rounds; round++) {
+            decodeMorton3DBatch(round, count, x.data(), y.data(), z.data());
+            sum += x[count - 1] + y[count / 2] + z[0];
+        }
+        benchSink += sum;
+    });
+}
+
+void benchSynthetic(double fill, size_t chunkCount, const std::string& tempDir) {
+    char label[32];
+    snprintf(label, sizeof(label), "%g%%", fill * 100.0);
+    std::vector<std::vector<uint8_t>> chunkStreams;
+    uint64_t streamBytes = 0;
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        chunkStreams.push_back(syntheticDsStream(fill, chunk + 1));
+        streamBytes += chunkStreams.back().size();
+    }
+    uint64_t streamVoxels = streamBytes / 2; // ns/voxel is per stream entry so fill ratios compare
+    std::cout << "-- synthetic " << label << " fill, " << chunkCount << " chunks" << std::endl;
+
+    bench(std::string("decodeVoxels ") + label, streamVoxels, streamBytes, [&] {
+        size_t total = 0;
+        for (const auto& ds : chunkStreams) {
+            total += decodeVoxels(ds, 0, 0).size();
+        }
+        benchSink += total;
+    });
+
+    VmaxModel model("synthetic.vmaxb");
+    bench(std::string("decodeVoxelsInto+finalize ") + label, streamVoxels, streamBytes, [&] {
+        model = VmaxModel("synthetic.vmaxb");
+        for (size_t chunk = 0; chunk < chunkStreams.size(); chunk++) {
+            decodeVoxelsInto(chunkStreams[chunk].data(), chunkStreams[chunk].size(), chunk, 0, model);
+        }
+        model.finalize();
+    });
+
+    std::string vmaxbName = tempDir + "/bench_" + std::to_string(static_cast<int>(fill * 100)) + ".vmaxb";
+    if (writeSyntheticVmaxb(vmaxbName, chunkStreams)) {
+        uint64_t fileBytes = std::filesystem::file_size(vmaxbName);
+        bench(std::string("readPlist ") + label, streamVoxels, fileBytes, [&] {
+            plist_t root = readPlist(vmaxbName, true);
+            if (!root) throw std::runtime_error("Failed to read " + vmaxbName);
+            plist_free(root);
+        });
+        bench(std::string("readVmaxSnapshots ") + label, streamVoxels, fileBytes, [&] {
+            std::vector<uint8_t> plistBytes;
+            std::vector<VmaxSnapshotRecord> records;
+            if (!readVmaxbBytes(vmaxbName, plistBytes) || !readVmaxSnapshots(plistBytes.data(), plistBytes.size(), records)) {
+                throw std::runtime_error("Failed to walk " + vmaxbName);
+            }
+            benchSink += records.size();
+        });
+        plist_t root = readPlist(vmaxbName, true);
+        plist_t snapshots = plist_dict_get_item(root, "snapshots");
+        uint32_t snapshotCount = plist_array_get_size(snapshots);
+        bench(std::string("vmaxVoxelInfo ") + label, streamVoxels, streamBytes, [&] {
+            size_t total = 0;
+            for (uint32_t i = 0; i < snapshotCount; i++) {
+                plist_t snapshot = plist_array_get_item(snapshots, i);
+                plist_t datastream = getNestedPlistNode(snapshot, {"s", "ds"});
+                VmaxChunkInfo chunkInfo = vmaxChunkInfo(snapshot);
+                total += vmaxVoxelInfo(datastream, chunkInfo.id, chunkInfo.mortoncode).size();
+            }
+            benchSink += total;
+        });
+        plist_free(root);
+        std::filesystem::remove(vmaxbName);
+    } else {
+        std::cout << "Skipping readPlist, could not write " << vmaxbName << std::endl;
+    }
+
+    std::vector<VmaxRGBA> palette = syntheticPalette();
+    std::array<VmaxMaterial, 8> materials = syntheticMaterials();
+
+    std::string vxcName = tempDir + "/bench_" + std::to_string(static_cast<int>(fill * 100)) + ".vxc";
+    VmaxDecodedModel decoded("synthetic.vmaxb");
+    decoded.model = model;
+    decoded.palette = palette;
+    decoded.materials = materials;
+    bench(std::string("writeVmaxChunkFile ") + label, streamVoxels, 0, [&] {
+        if (!writeVmaxChunkFile(vxcName, decoded)) throw std::runtime_error("Failed to write " + vxcName);
+    });
+    uint64_t vxcBytes = std::filesystem::file_size(vxcName);
+    bench(std::string("VmaxChunkFile load ") + label, streamVoxels, vxcBytes, [&] {
+        VmaxChunkFile vxc(vxcName);
+        auto loaded = vxc.load("synthetic.vmaxb");
+        if (!loaded) throw std::runtime_error("Failed to load " + vxcName);
+        benchSink += loaded->model.positions.size();
+    });
+    std::filesystem::remove(vxcName);
+
+    ConvertOptions options;
+    benchAddModel(std::string("addModelToScene instance ") + label, model, palette, materials, options);
+    options.meshGeometry = true;
+    benchAddModel(std::string("addModelToScene mesh ") + label, model, palette, materials, options);
+
+    bench(std::string("downsampleVmaxModel ") + label, model.positions.size(), 0, [&] {
+        benchSink += downsampleVmaxModel(model).positions.size();
+    });
+    options.meshGeometry = false;
+    options.lod = 2;
+    benchAddModel(std::string("addModelToScene instance lod2 ") + label, model, palette, materials, options);
+}
+
+// Every model of a real .vmax directory, stages timed one after the other
+void benchSample(const std::string& vmaxDir) {
+    std::cout << "-- " << vmaxDir << std::endl;
+    VmaxZipMount zipMount(vmaxDir); // .vmax.zip samples are read in place
+    JsonVmaxSceneParser vmaxSceneParser;
+    vmaxSceneParser.parseScene(vmaxDir + "/scene.json");
+    auto modelVmaxbMap = vmaxSceneParser.getModelContentVMaxbMap();
+    std::string sampleName = std::filesystem::path(vmaxDir).filename().string();
+    if (sampleName.empty()) sampleName = std::filesystem::path(vmaxDir).parent_path().filename().string();
+    for (const auto& [vmaxContentName, vmaxModelList] : modelVmaxbMap) {
+        const JsonModelInfo& jsonModelInfo = vmaxModelList.front();
+        std::string label = sampleName + "/" + vmaxContentName;
+        std::string vmaxbName = vmaxDir + "/" + jsonModelInfo.dataFile;
+        uint64_t fileBytes = VmaxSourceFile(vmaxbName).size(); // works for entries of a mounted .vmax.zip too
+
+        VmaxDecodedModel decoded = decodeVmaxModel(vmaxDir, vmaxContentName, jsonModelInfo, convertOptions.decode);
+        uint64_t voxels = decoded.model.positions.size();
+        bench("readPlist " + label, voxels, fileBytes, [&] {
+            plist_t root = readPlist(vmaxbName, true);
+            if (!root) throw std::runtime_error("Failed to read " + vmaxbName);
+            plist_free(root);
+        });
+        bench("decodeVmaxModel " + label, voxels, fileBytes, [&] {
+            VmaxDecodedModel again = decodeVmaxModel(vmaxDir, vmaxContentName, jsonModelInfo, convertOptions.decode);
+            benchSink += again.model.positions.size();
+        });
+        benchAddModel("addModelToScene " + label, decoded.model, decoded.palette, decoded.materials, convertOptions);
+    }
+}
+
+json resultsToJson() {
+    json results = json::object();
+    for (const auto& result : benchResults) {
+        results[result.name] = {
+            {"ms", result.nanos / 1e6},
+            {"nsPerVoxel", result.voxels ? result.nanos / result.voxels : 0.0},
+            {"mbPerSec", result.bytes && result.nanos > 0 ? result.bytes / (result.nanos / 1e9) / 1e6 : 0.0},
+            {"peakRssMB", result.peakRss}
+        };
+    }
+    return json{{"version", 1}, {"reps", benchReps}, {"results", results}};
+}
+
+// Stages more than tolerance slower than the baseline are flagged
+// @return number of regressed stages
+int compareToBaseline(const std::string& baselineName, double tolerance) {
+    std::ifstream baselineFile(baselineName);
+    if (!baselineFile) {
+        std::cerr << "Could not open baseline: " << baselineName << std::endl;
+        return 0;
+    }
+    json baseline = json::parse(baselineFile, nullptr, false);
+    if (baseline.is_discarded() || !baseline.contains("results")) {
+        std::cerr << "Not a vmaxbench baseline: " << baselineName << std::endl;
+        return 0;
+    }
+    int regressions = 0;
+    std::cout << "== compared to " << baselineName << " ==" << std::endl;
+    for (const auto& result : benchResults) {
+        if (!baseline["results"].contains(result.name)) continue;
+        double before = baseline["results"][result.name].value("ms", 0.0);
+        double now = result.nanos / 1e6;
+        if (before <= 0) continue;
+        double change = (now - before) / before;
+        bool regressed = change > tolerance;
+        regressions += regressed ? 1 : 0;
+        char line[256];
+        snprintf(line, sizeof(line), "%-40s %10.2f ms  was %10.2f ms  %+7.1f%%%s",
+                 result.name.c_str(), now, before, change * 100.0, regressed ? "  SLOWER" : "");
+        std::cout << line << std::endl;
+    }
+    return regressions;
+}
+
+} // namespace
+
+int DL_main(dl::Args& args) {
+    args.add("i",  "input",         "", "comma separated .vmax directories to benchmark besides the synthetic streams");
+    args.add("r",  "reps",          "", "runs per stage, the fastest is reported, default 5");
+    args.add("c",  "chunks",        "", "32x32x32 chunks per synthetic model, default 64");
+    args.add("b",  "baseline",      "", "compare against results saved with --save-baseline");
+    args.add("sb", "save-baseline", "", "write the results as json to this file");
+    args.add("t",  "tolerance",     "", "percent slower than the baseline before a stage is flagged, default 10");
+    args.add("j",  "jobs",          "", "passed on like vmaxtui --jobs");
+    args.add("s",  "snapshot",      "", "passed on like vmaxtui --snapshot");
+
+    if (args.helpRequested()) {
+        std::cout << args.help("© 2025 Harvey Fong", "vmaxbench", "1.0") << std::endl;
+        return 0;
+    }
+    if (args.have("--reps")) {
+        benchReps = std::max(1, std::atoi(args.value("--reps").buf()));
+    }
+    size_t chunkCount = 64;
+    if (args.have("--chunks")) {
+        chunkCount = std::min(512, std::max(1, std::atoi(args.value("--chunks").buf())));
+    }
+    if (args.have("--jobs")) {
+        convertOptions.jobs = std::max(0, std::atoi(args.value("--jobs").buf()));
+    }
+    if (args.have("--snapshot")) {
+        convertOptions.decode.snapshotLimit = std::max(0, std::atoi(args.value("--snapshot").buf()));
+    }
+    double tolerance = 0.10;
+    if (args.have("--tolerance")) {
+        tolerance = std::max(0.0, std::atof(args.value("--tolerance").buf()) / 100.0);
+    }
+
+    std::cout << "vmaxbench, best of " << benchReps << " runs per stage" << std::endl;
+    benchMorton();
+    std::string tempDir = std::filesystem::temp_directory_path().string();
+    for (double fill : {0.01, 0.10, 0.50, 1.0}) {
+        benchSynthetic(fill, chunkCount, tempDir);
+    }
+
+    if (args.have("--input")) {
+        std::stringstream inputs(args.value("--input").buf());
+        std::string vmaxDir;
+        while (std::getline(inputs, vmaxDir, ',')) {
+            if (vmaxDir.empty()) continue;
+            try {
+                benchSample(vmaxDir);
+            } catch (const std::exception& e) {
+                std::cerr << "Skipping " << vmaxDir << ": " << e.what() << std::endl;
+            }
+        }
+    }
+    std::cout << "Peak RSS: " << peakRssMB() << " MB" << std::endl;
+
+    int regressions = 0;
+    if (args.have("--baseline")) {
+        regressions = compareToBaseline(args.value("--baseline").buf(), tolerance);
+    }
+    if (args.have("--save-baseline")) {
+        std::string baselineName = args.value("--save-baseline").buf();
+        std::ofstream baselineFile(baselineName);
+        baselineFile << resultsToJson().dump(2) << std::endl;
+        if (!baselineFile) std::cerr << "Failed to write baseline: " << baselineName << std::endl;
+    }
+    return regressions > 0 ? 1 : 0;
+}
@@ -194,6 +194,10 @@ The 't' field in the snapshot's 's.id' dictionary indicates the type of snapshot
 #include <atomic>
 #include <mutex> // Add this line for std::mutex and std::lock_guard
 #include <map> // Add this line for std::map
+#include <set> // For std::set
+#include <memory> // For std::unique_ptr
+#include <optional> // For std::optional
+#include <algorithm> // For std::max
 
 #include <cstdlib> // For std::system
 #include <stdexcept> // For std::runtime_error
@@ -207,8 +211,27 @@ The 't' field in the snapshot's 's.id' dictionary indicates the type of snapshot
 #include <sys/wait.h> // For waitpid
 #endif
 
+// Conversion settings gathered from the command line
+struct ConvertOptions {
+    unsigned jobs = 0; // model decode threads, 0 = all cores
+    bool cullHidden = false; // drop voxels enclosed by opaque voxels
+    bool meshGeometry = false; // greedy meshed faces instead of instanced cubes
+    int lod = 0; // --lod, 2x2x2 downsampling steps before building, see buildVmaxLod()
+    VmaxDecodeOptions decode; // snapshot selection
+    VmaxRegion region; // --region, world space box, objects and chunks outside it are skipped
+    std::string vxcPrefix; // when set each decoded model is also written to <vxcPrefix><contentsN>.vxc
+};
+ConvertOptions convertOptions;
+bool writeVxc = false; // --vxc, see convertOptionsFor()
+// Decoded models reused across conversions, see --cachedir
+VmaxModelCache modelCache;
+// --stats and --stats-json, see reportStats()
+bool statsTable = false;
+std::string statsJsonName;
+
 dl::bella_sdk::Node essentialsToScene(dl::bella_sdk::Scene& belScene);
-dl::bella_sdk::Node addModelToScene(dl::bella_sdk::Scene& belScene, dl::bella_sdk::Node& belWorld, const VmaxModel& vmaxModel, const std::vector<VmaxRGBA>& vmaxPalette, const std::array<VmaxMaterial, 8>& vmaxMaterial); 
+dl::bella_sdk::Node addQuadMeshToScene(dl::bella_sdk::Scene& belScene, const dl::String& meshName, const std::vector<VmaxQuad>& quads);
+dl::bella_sdk::Node addModelToScene(dl::bella_sdk::Scene& belScene, dl::bella_sdk::Node& belWorld, const VmaxModel& vmaxModel, const std::vector<VmaxRGBA>& vmaxPalette, const std::array<VmaxMaterial, 8>& vmaxMaterial, const ConvertOptions& options, std::vector<dl::bella_sdk::Node>* createdNodes = nullptr, std::set<std::string>* usedMaterials = nullptr); 
 
 dl::String programName = "vmaxtui";
 
@@ -219,15 +242,110 @@ std::mutex currentRenderMutex;  // Add mutex for thread safety
 
 UpdateListener* global_ul = nullptr;          // Global pointer to UpdateListener
 // Queues for incoming files from the efsw watcher
-FileQueue fileQueue;  
-FileQueue unfileQueue;  
-FileQueue processQueue;  
-std::mutex fileQueueMutex;  // Add mutex for thread safety
-std::mutex unfileQueueMutex;  // Add mutex for thread safety
-std::mutex processQueueMutex;  // Add mutex for thread safety
+PathHandoffQueue fileQueue;  
+PathHandoffQueue unfileQueue;  
+WakeSignal watchWake;  // Wakes the --watchdir loop on file events and render stops
+
+// A converted .vmax together with what it was built from, kept between conversions
+// so a re-export only touches the nodes that changed, see updateVmaxBellaScene()
+struct VmaxBellaScene {
+    dl::bella_sdk::Scene scene;
+    VmaxScene vmaxScene;                                                // scene.json it was built from
+    std::map<std::string, uint64_t> modelKeys;                          // content name -> vmaxModelCacheKey()
+    std::map<std::string, std::vector<dl::bella_sdk::Node>> modelNodes; // content name -> nodes made by addModelToScene
+    std::map<std::string, std::set<std::string>> modelMaterials;        // content name -> interned vmaxMat nodes it uses
+};
 
 //Forward declares
-dl::bella_sdk::Scene convertVmaxToBella( const dl::String& vmaxDirName);
+dl::bella_sdk::Scene convertVmaxToBella( const dl::String& vmaxDirName, const ConvertOptions& options, VmaxBellaScene* keepState = nullptr);
+bool updateVmaxBellaScene(VmaxBellaScene& state, const dl::String& vmaxDirName, const ConvertOptions& options);
+void buildVmaxScene(dl::bella_sdk::Scene& belScene, const dl::String& vmaxDirName, const ConvertOptions& options, VmaxBellaScene* keepState = nullptr);
+void prefetchVmaxModels(const dl::String& vmaxDirName, const ConvertOptions& options);
+std::vector<std::string> collectBatchInputs(const std::string& batchSpec);
+int runBatch(const std::string& batchSpec, const std::string& outputDir, const std::string& manifestName, unsigned workers);
+
+// Write a scene to a .bsz, timed for --stats
+// The conversion is over once it is written, so the scratch arena of this thread is freed too
+bool writeBellaScene(dl::bella_sdk::Scene& belScene, const std::string& bszName) {
+    VmaxStatTimer timer(vmaxStats().sceneWriteNanos);
+    vmaxStats().sceneWrites++;
+    bool written = belScene.write(bszName.c_str());
+    vmaxThreadArena().release();
+    return written;
+}
+
+// Print the pipeline stats as asked for by --stats and --stats-json, counters are totals since start
+void reportStats() {
+    if (statsTable) {
+        vmaxStats().print(std::cout);
+    } else if (convertOptions.decode.mergeColorsDeltaE > 0.0f) {
+        vmaxStats().printMergeColors(std::cout); // the instancer counts are what --merge-colors is tuned by
+    }
+    if (!statsJsonName.empty()) {
+        std::string statsJson = vmaxStats().toJson().dump(2);
+        if (statsJsonName == "-") {
+            std::cout << statsJson << std::endl;
+        } else {
+            std::ofstream statsFile(statsJsonName);
+            statsFile << statsJson << std::endl;
+            if (!statsFile) std::cerr << "Failed to write stats to: " << statsJsonName << std::endl;
+        }
+    }
+}
+
+// foo.vmax, foo.vmax/ or foo.vmax.zip becomes foo.bsz next to it
+std::string bszPathForVmax(std::string vmaxPath) {
+    while (!vmaxPath.empty() && (vmaxPath.back() == '/' || vmaxPath.back() == '\\')) vmaxPath.pop_back();
+    if (endsWith(vmaxPath, ".zip")) vmaxPath.erase(vmaxPath.size() - 4);
+    if (endsWith(vmaxPath, ".vmax")) vmaxPath.erase(vmaxPath.size() - 5);
+    return vmaxPath + ".bsz";
+}
+
+// Render order of a queued .bsz in --watchdir mode, lowest first, see PriorityFileQueue
+// Small scenes go first so a quick preview does not wait behind a big one. Sizes are bucketed
+// by power of two, (2^(k-1), 2^k] bytes share a bucket, and within a bucket the most recently
+// modified goes first. Two files close in size can still land in neighbouring buckets
+int64_t renderRank(const std::string& bszPath) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(bszPath, error);
+    if (error) size = 0;
+    int64_t sizeClass = 0;
+    while (sizeClass < 63 && (uintmax_t(1) << sizeClass) < size) sizeClass++;
+    auto modified = std::filesystem::last_write_time(bszPath, error);
+    int64_t modifiedSeconds = error ? 0 : std::chrono::duration_cast<std::chrono::seconds>(modified.time_since_epoch()).count();
+    return (sizeClass << 40) - modifiedSeconds;
+}
+
+// Options of a conversion written to bszPath, --vxc files go next to it as foo.contents1.vxc
+ConvertOptions convertOptionsFor(const std::string& bszPath, ConvertOptions options = convertOptions) {
+    if (writeVxc) options.vxcPrefix = bszPath.substr(0, bszPath.size() - 4) + ".";
+    return options;
+}
+
+// Write the .vxc of a decoded model if the options ask for one, a failed write does not fail the conversion
+void writeModelVxc(const ConvertOptions& options, const VmaxDecodedModel& decoded) {
+    if (options.vxcPrefix.empty()) return;
+    std::string contentName = decoded.model.vmaxbFileName;
+    if (endsWith(contentName, ".vmaxb")) contentName.erase(contentName.size() - 6);
+    std::string vxcName = options.vxcPrefix + contentName + ".vxc";
+    if (!writeVmaxChunkFile(vxcName, decoded)) {
+        std::cerr << "Failed to write " << vxcName << std::endl;
+    }
+}
+
+// Decode options of every content, with the chunks --region does not need masked off
+// A content no object in the region uses gets an empty mask and is not decoded at all
+// @param outObjectInRegion - per object, false when --region leaves it out
+std::vector<VmaxDecodeOptions> regionDecodeOptions(const VmaxScene& vmaxScene, const ConvertOptions& options, std::vector<bool>& outObjectInRegion) {
+    std::vector<std::array<uint64_t, 8>> chunkMasks = vmaxRegionChunkMasks(vmaxScene, options.region, outObjectInRegion);
+    std::vector<VmaxDecodeOptions> decodeOptions(chunkMasks.size(), options.decode);
+    for (size_t contentIndex = 0; contentIndex < chunkMasks.size(); contentIndex++) {
+        for (size_t word = 0; word < 8; word++) {
+            decodeOptions[contentIndex].chunkMask[word] &= chunkMasks[contentIndex][word];
+        }
+    }
+    return decodeOptions;
+}
 
 // Signal handler for ctrl-c
 void sigend( int ) {
@@ -270,10 +388,21 @@ static void log(void* /*ctx*/, dl::LogType type, const char* msg)
  * - Handle error conditions
  * - Store and retrieve the current progress state
  * - Can be passed by reference unlike Engine
+ * Each engine of the --render-engines pool has its own observer and active flag
  */
  struct MyEngineObserver : public dl::bella_sdk::EngineObserver
  {
  public:
+     explicit MyEngineObserver(std::atomic<bool>& activeFlag = active_render) : active(activeFlag) {
+     }
+
+     // Prefix of the progress lines, names the engine and file when several render at once
+     void setLabel(const std::string& newLabel) {
+         std::lock_guard<std::mutex> lock(progressMutex);
+         label = newLabel;
+         lastProgress.clear();
+     }
+
      // Called when a rendering pass starts
      void onStarted(dl::String pass) override
      {
@@ -290,8 +419,14 @@ static void log(void* /*ctx*/, dl::LogType type, const char* msg)
      // Called to update rendering progress (percentage, time remaining, etc)
      void onProgress(dl::String pass, dl::bella_sdk::Progress progress) override
      {
-         std::cout << progress.toString().buf() << std::endl;
-         //setString(new std::string(progress.toString().buf()));
+         std::string line = progress.toString().buf();
+         std::string prefix;
+         {
+             std::lock_guard<std::mutex> lock(progressMutex);
+             lastProgress = line;
+             prefix = label;
+         }
+         std::cout << prefix << line << std::endl;
          //logInfo("%s [%s]", progress.toString().buf(), pass.buf());
      }
  
@@ -310,40 +445,54 @@ static void log(void* /*ctx*/, dl::LogType type, const char* msg)
      void onStopped(dl::String pass) override
      {
          dl::logInfo("Stopped %s", pass.buf());
-         active_render = false;
+         active = false;
+         watchWake.notify(); // start the next queued file
      }
  
-     // Returns the current progress as a string
+     // Returns the current progress as a string, empty before the first progress of a render
+     // Called from the main loop while the engine thread updates it
      std::string getProgress() const {
-         std::string* currentProgress = progressPtr.load();
-         if (currentProgress) {
-             return *currentProgress;
-         } else {
-             return "";
-         }
-     }
- 
-     // Cleanup resources in destructor
-     ~MyEngineObserver() {
-         setString(nullptr);
+         std::lock_guard<std::mutex> lock(progressMutex);
+         return lastProgress;
      }
  private:
-     // Thread-safe pointer to current progress string
-     std::atomic<std::string*> progressPtr{nullptr};
- 
-     // Helper function to safely update the progress string
-     void setString(std::string* newStatus) {
-         std::string* oldStatus = progressPtr.exchange(newStatus);
-         delete oldStatus;  // Clean up old string if it exists
-     }
+     std::atomic<bool>& active; // cleared when a render stops
+     mutable std::mutex progressMutex;
+     std::string lastProgress; // of the current render
+     std::string label;
  };
 
+// vmaxbench.cpp builds this file with VMAXTUI_NO_MAIN and brings its own DL_main
+#ifndef VMAXTUI_NO_MAIN
 int DL_main(dl::Args& args) {
     args.add("i", "input", "", "vmax directory or vmax.zip file");
-    args.add("o", "output", "", "set output bella file name");
+    args.add("o", "output", "", "set output bella file name, in --batch mode the directory the .bsz files go to");
     args.add("tp",  "thirdparty",   "",   "prints third party licenses");
     args.add("li",  "licenseinfo",   "",   "prints license info");
     args.add("w",  "watchdir",   "",   "watch directory for changes");
+    args.add("b",  "batch",      "",   "convert every .vmax in a list file, glob or directory tree in one process");
+    args.add("m",  "manifest",   "",   "in --batch mode write one json line per input to this file, default vmaxtui_manifest.jsonl");
+    args.add("cw", "convert-workers", "", "number of .vmax files converted at once in --watchdir and --batch mode, default 2");
+    args.add("inc", "incremental", "", "in --watchdir mode keep converted scenes and only rebuild what changed on re-export");
+    args.add("is", "incremental-scenes", "", "in --incremental mode keep at most this many scenes, the least recently converted are rebuilt in full, default 8");
+    args.add("pv", "preview",    "",   "in --watchdir mode render converted .vmax live in memory, re-exports update the running render");
+    args.add("pr", "preview-res", "",  "preview resolution WxH, default 200x200");
+    args.add("pt", "preview-time", "", "stop a preview render after this many seconds, default no limit");
+    args.add("pn", "preview-noise", "", "stop a preview render at this noise level, default the scene's setting");
+    args.add("l",  "lod",        "",   "in --watchdir mode build scenes N 2x2x2 levels coarser with scaled cubes, default 0 full resolution");
+    args.add("db", "debounce",   "",   "ms a watched file must stop changing before it is processed, default 500");
+    args.add("j",  "jobs",   "",   "number of threads used to decode models, default all cores");
+    args.add("ch", "cull-hidden",   "",   "skip voxels fully enclosed by opaque voxels");
+    args.add("cd", "cachedir",   "",   "directory to cache decoded models in, reused across runs");
+    args.add("st", "stats",      "",   "print per stage timings and counters after each conversion");
+    args.add("sj", "stats-json", "",   "write the same stats as json to this file after each conversion, - for stdout");
+    args.add("s",  "snapshot",   "",   "rebuild models as of snapshot index N, default latest");
+    args.add("g",  "geometry",   "",   "voxel geometry: instance (default, bevelled cubes) or mesh (greedy meshed faces)");
+    args.add("r",  "region",     "",   "only convert what touches the world space box minx,miny,minz,maxx,maxy,maxz");
+    args.add("vx", "vxc",        "",   "also write each decoded model as a compact .vxc voxel file next to the .bsz");
+    args.add("mc", "merge-colors", "", "merge colors of a material closer than this CIELAB deltaE into one instancer, e.g. 2.3");
+    args.add("re", "render-engines", "", "in --watchdir mode render this many .bsz at once, one engine each, default 1");
+    args.add("rt", "render-threads", "", "render threads per engine, default all cores split over --render-engines");
 
     // If --help was requested, print help and exit
     if (args.helpRequested()) {
@@ -364,31 +513,89 @@ int DL_main(dl::Args& args) {
         std::cout << initializeThirdPartyLicences() << std::endl;
         return 0;
     }
+
+    if (args.have("--jobs")) {
+        convertOptions.jobs = std::max(0, std::atoi(args.value("--jobs").buf()));
+    }
+    convertOptions.cullHidden = args.have("--cull-hidden");
+    writeVxc = args.have("--vxc");
+    if (args.have("--region")) {
+        VmaxRegion& region = convertOptions.region;
+        if (sscanf(args.value("--region").buf(), "%lf,%lf,%lf,%lf,%lf,%lf", &region.min[0], &region.min[1], &region.min[2],
+                   &region.max[0], &region.max[1], &region.max[2]) != 6) {
+            std::cout << "Bad --region, expected minx,miny,minz,maxx,maxy,maxz" << std::endl;
+            return 0;
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            if (region.min[axis] > region.max[axis]) std::swap(region.min[axis], region.max[axis]);
+        }
+        region.enabled = true;
+        std::cout << "Region: " << region.min[0] << "," << region.min[1] << "," << region.min[2] << " to "
+                  << region.max[0] << "," << region.max[1] << "," << region.max[2] << std::endl;
+    }
+    statsTable = args.have("--stats");
+    if (args.have("--stats-json")) {
+        statsJsonName = args.value("--stats-json").buf();
+    }
+    if (args.have("--cachedir")) {
+        modelCache.setCacheDir(args.value("--cachedir").buf());
+    }
+    if (args.have("--snapshot")) {
+        convertOptions.decode.snapshotLimit = std::max(0, std::atoi(args.value("--snapshot").buf()));
+    }
+    if (args.have("--merge-colors")) {
+        convertOptions.decode.mergeColorsDeltaE = std::max(0.0f, static_cast<float>(std::atof(args.value("--merge-colors").buf())));
+    }
+    if (args.have("--geometry")) {
+        dl::String geometry = args.value("--geometry");
+        if (geometry == "mesh") {
+            convertOptions.meshGeometry = true;
+        } else if (geometry != "instance") {
+            std::cout << "Unknown --geometry " << geometry.buf() << ", use instance or mesh" << std::endl;
+            return 0;
+        }
+    }
     if (args.have("--input"))
     {
         dl::String bszName;
         dl::String vmaxDirName = args.value("--input");
         auto vmaxPath = dl::Path();
         if (!vmaxPath.exists(vmaxDirName)) {
-            std::cout << "Cannot find directory " << vmaxDirName.buf() << std::endl;
+            std::cout << "Cannot find " << vmaxDirName.buf() << std::endl;
             return 0;
         }
 
-        bszName = vmaxDirName.replace("vmax", "bsz");
-        dl::bella_sdk::Scene belScene = convertVmaxToBella(vmaxDirName);
-        belScene.write(bszName.buf());
+        bszName = dl::String(bszPathForVmax(vmaxDirName.buf()).c_str());
+        try {
+            dl::bella_sdk::Scene belScene = convertVmaxToBella(vmaxDirName, convertOptionsFor(bszName.buf()));
+            writeBellaScene(belScene, bszName.buf());
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to convert " << vmaxDirName.buf() << ": " << e.what() << std::endl;
+            return 1;
+        }
+        reportStats();
      }
 
+    if (args.have("--batch")) {
+        unsigned batchWorkers = 2;
+        if (args.have("--convert-workers")) {
+            batchWorkers = static_cast<unsigned>(std::max(1, std::atoi(args.value("--convert-workers").buf())));
+        }
+        std::string outputDir = args.have("--output") ? args.value("--output").buf() : "";
+        std::string manifestName = args.have("--manifest") ? args.value("--manifest").buf() : "vmaxtui_manifest.jsonl";
+        return runBatch(args.value("--batch").buf(), outputDir, manifestName, batchWorkers);
+    }
+
     if (args.have("--watchdir")) {
         std::cout << "VmaxTUI server started ..." << std::endl;
         std::string watchDir = args.value("--watchdir").buf();
         // Initialize the UpdateListener with references to our queues and mutexes
         global_ul = new UpdateListener( fileQueue, 
                                         unfileQueue, 
-                                        processQueue, 
-                                        fileQueueMutex, 
-                                        unfileQueueMutex, 
-                                        processQueueMutex);
+                                        watchWake);
+        if (args.have("--debounce")) {
+            global_ul->setQuietPeriod(std::chrono::milliseconds(std::max(0, std::atoi(args.value("--debounce").buf()))));
+        }
     
         // TODO: Set up your file watcher and add the listener to it if needed
         efsw::FileWatcher* fileWatcher = new efsw::FileWatcher();
@@ -396,34 +603,353 @@ int DL_main(dl::Args& args) {
         fileWatcher->watch();
 
         // Create persistent instances outside the loop
-        FileQueue renderQueue;
+        FileQueue convertQueue;  // .vmax waiting for a conversion worker
+        PriorityFileQueue renderQueue; // .bsz waiting for an engine, see renderRank()
         FileQueue renderUnqueue;
-        dl::bella_sdk::Engine engine;
-        MyEngineObserver engineObserver;
-        engine.subscribe(&engineObserver);
-        engine.scene().loadDefs();
 
-        while (true) {
-            // Append items from incoming queues to our persistent queues for thread safety
-            if (renderQueue.empty() ) {
-                renderUnqueue.clear(); // catch edge case where deletes have accumulated
+        // Pool of engines, each renders its own .bsz on its share of the cores
+        // With --preview the first engine shows the live preview and the others take the .bsz
+        struct RenderSlot {
+            std::atomic<bool> active{false};
+            MyEngineObserver observer{active}; // declared before engine so it outlives it
+            dl::bella_sdk::Engine engine;
+            dl::String currentRender; // .bsz or --preview .vmax being rendered, kept to match deletes
+            std::chrono::steady_clock::time_point renderStarted;
+        };
+        unsigned renderEngines = 1;
+        if (args.have("--render-engines")) {
+            renderEngines = static_cast<unsigned>(std::max(1, std::atoi(args.value("--render-engines").buf())));
+        }
+        unsigned renderThreads = 0; // 0 keeps the scene's setting, which is auto
+        if (args.have("--render-threads")) {
+            renderThreads = static_cast<unsigned>(std::max(0, std::atoi(args.value("--render-threads").buf())));
+        } else if (renderEngines > 1) {
+            renderThreads = std::max(1u, std::thread::hardware_concurrency() / renderEngines);
+        }
+        std::vector<std::unique_ptr<RenderSlot>> renderSlots;
+        for (unsigned i = 0; i < renderEngines; i++) {
+            renderSlots.push_back(std::make_unique<RenderSlot>());
+            renderSlots.back()->engine.subscribe(&renderSlots.back()->observer);
+            renderSlots.back()->engine.scene().loadDefs();
+        }
+        RenderSlot& previewSlot = *renderSlots[0];
+
+        // Preview render settings, applied to every scene the engine gets
+        dl::Vec2 previewResolution {200, 200};
+        if (args.have("--preview-res")) {
+            int width = 0, height = 0;
+            if (sscanf(args.value("--preview-res").buf(), "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                previewResolution = dl::Vec2 {static_cast<double>(width), static_cast<double>(height)};
+            } else {
+                std::cout << "Bad --preview-res, expected WxH, using 200x200" << std::endl;
             }
+        }
+        std::chrono::milliseconds previewTimeBudget(0); // 0 is no limit
+        if (args.have("--preview-time")) {
+            previewTimeBudget = std::chrono::milliseconds(static_cast<long long>(std::max(0.0, std::atof(args.value("--preview-time").buf())) * 1000.0));
+        }
+        double previewNoise = args.have("--preview-noise") ? std::atof(args.value("--preview-noise").buf()) : 0.0;
+        // Watch mode renders are previews, --input and --batch conversions stay at full resolution
+        if (args.have("--lod")) {
+            convertOptions.lod = std::min(7, std::max(0, std::atoi(args.value("--lod").buf())));
+        }
+        auto applyPreviewSettings = [&](dl::bella_sdk::Scene belScene) {
+            belScene.camera()["resolution"] = previewResolution;
+            if (previewNoise > 0.0) {
+                belScene.beautyPass()["targetNoise"] = previewNoise;
+            }
+            if (renderThreads > 0) {
+                belScene.settings()["threads"] = dl::bella_sdk::Input(static_cast<int>(renderThreads));
+            }
+        };
+
+        // --preview builds converted .vmax straight into the engine's scene, a re-export of the
+        // same .vmax is applied as a delta with updateVmaxBellaScene and the progressive render restarts
+        const bool preview = args.have("--preview");
+        std::unique_ptr<VmaxBellaScene> previewState; // what the engine's scene was built from
+        std::string previewPath;                      // .vmax in the engine's scene
+        if (preview) {
+            previewSlot.engine.enableInteractiveMode(); // scene edits restart the render instead of needing a reload
+        }
+        // .bsz renders go to every engine but the preview one, unless it is the only one
+        auto rendersBsz = [&](size_t slotIndex) {
+            return !preview || renderSlots.size() == 1 || slotIndex > 0;
+        };
+
+        // Conversion workers turn a .vmax into a .bsz written next to it, the main loop then
+        // renders it. Linked by bounded queues so converting file N+1 overlaps rendering file N
+        // and the main loop stays free to handle deletes
+        struct ConvertedScene {
+            std::string vmaxPath;
+            std::string bszPath; // empty for --preview, the scene is built into the engine instead
+            std::string error; // empty on success
+        };
+        unsigned convertWorkers = 2;
+        if (args.have("--convert-workers")) {
+            convertWorkers = static_cast<unsigned>(std::max(1, std::atoi(args.value("--convert-workers").buf())));
+        }
+        // Split the cores between the workers unless --jobs asked for something else, like --batch
+        if (convertOptions.jobs == 0) {
+            convertOptions.jobs = std::max(1u, std::thread::hardware_concurrency() / convertWorkers);
+        }
+        BoundedQueue<std::string> convertJobs(convertWorkers);
+        BoundedQueue<ConvertedScene> convertedScenes(convertWorkers * 2);
+        std::mutex conversionMutex;
+        std::set<std::string> cancelledConversions; // .vmax deleted while converting
+        std::map<std::string, std::chrono::steady_clock::time_point> convertedOutputs; // .bsz written by the workers
+        std::map<std::string, std::shared_ptr<VmaxBellaScene>> previousScenes; // --incremental, last conversion per .vmax
+        std::deque<std::string> previousOrder; // keys of previousScenes, least recently converted first
+        const bool incremental = args.have("--incremental");
+        size_t maxIncrementalScenes = 8; // each one holds a whole Bella scene
+        if (args.have("--incremental-scenes")) {
+            maxIncrementalScenes = static_cast<size_t>(std::max(1, std::atoi(args.value("--incremental-scenes").buf())));
+        }
+        // Callers hold conversionMutex
+        auto forgetPreviousScene = [&](const std::string& vmaxPath) {
+            previousScenes.erase(vmaxPath);
+            previousOrder.erase(std::remove(previousOrder.begin(), previousOrder.end(), vmaxPath), previousOrder.end());
+        };
+        // Keep the scene of vmaxPath as the most recent one, the oldest go back to full rebuilds past the limit
+        auto keepPreviousScene = [&](const std::string& vmaxPath, std::shared_ptr<VmaxBellaScene> state) {
+            forgetPreviousScene(vmaxPath);
+            previousScenes[vmaxPath] = std::move(state);
+            previousOrder.push_back(vmaxPath);
+            while (previousOrder.size() > maxIncrementalScenes) {
+                previousScenes.erase(previousOrder.front());
+                previousOrder.pop_front();
+            }
+        };
+        std::vector<std::thread> converters;
+        for (unsigned i = 0; i < convertWorkers; i++) {
+            converters.emplace_back([&]() {
+                std::string vmaxPath;
+                while (convertJobs.pop(vmaxPath)) {
+                    ConvertedScene converted;
+                    converted.vmaxPath = vmaxPath;
+                    try {
+                        if (preview) {
+                            // The engine's scene is only touched by the main loop, decode is the slow part
+                            prefetchVmaxModels(dl::String(vmaxPath.c_str()), convertOptions);
+                            vmaxThreadArena().release();
+                            convertedScenes.push(std::move(converted));
+                            watchWake.notify();
+                            continue;
+                        }
+                        converted.bszPath = bszPathForVmax(vmaxPath);
+                        ConvertOptions options = convertOptionsFor(converted.bszPath);
+                        dl::bella_sdk::Scene belScene;
+                        if (incremental) {
+                            // Never converting the same .vmax twice at once, so the state is ours until we put it back
+                            std::shared_ptr<VmaxBellaScene> state;
+                            {
+                                std::lock_guard<std::mutex> lock(conversionMutex);
+                                auto previous = previousScenes.find(vmaxPath);
+                                if (previous != previousScenes.end()) state = previous->second;
+                            }
+                            if (!state || !updateVmaxBellaScene(*state, dl::String(vmaxPath.c_str()), options)) {
+                                state = std::make_shared<VmaxBellaScene>();
+                                convertVmaxToBella(dl::String(vmaxPath.c_str()), options, state.get());
+                            }
+                            belScene = state->scene;
+                            std::lock_guard<std::mutex> lock(conversionMutex);
+                            keepPreviousScene(vmaxPath, state);
+                        } else {
+                            belScene = convertVmaxToBella(dl::String(vmaxPath.c_str()), options);
+                        }
+                        bool cancelled;
+                        {
+                            std::lock_guard<std::mutex> lock(conversionMutex);
+                            cancelled = cancelledConversions.count(vmaxPath) > 0;
+                            // The watcher will report our own write, it must not queue a second render
+                            if (!cancelled) convertedOutputs[converted.bszPath] = std::chrono::steady_clock::now();
+                        }
+                        if (!cancelled && !writeBellaScene(belScene, converted.bszPath)) {
+                            converted.error = "Failed to write " + converted.bszPath;
+                            std::lock_guard<std::mutex> lock(conversionMutex);
+                            convertedOutputs.erase(converted.bszPath);
+                        }
+                    } catch (const std::exception& e) {
+                        converted.error = e.what();
+                    }
+                    convertedScenes.push(std::move(converted));
+                    watchWake.notify();
+                }
+            });
+        }
+        // Handed to a worker, not back yet, with the first watcher event of the .vmax for --stats
+        // The event time moves on to the .bsz it converts to, so latency runs from the edit to the render
+        std::map<std::string, std::optional<std::chrono::steady_clock::time_point>> converting;
+
+        // What every engine renders and its last progress, only printed when there are several
+        // A single engine prints its progress lines unlabelled like before
+        auto printRenderStatus = [&]() {
+            if (renderSlots.size() < 2) return;
+            std::cout << "== engines, " << renderQueue.size() << " queued" << std::endl;
+            for (size_t i = 0; i < renderSlots.size(); i++) {
+                const RenderSlot& slot = *renderSlots[i];
+                std::cout << "   [" << i + 1 << "] ";
+                if (slot.active) {
+                    std::cout << slot.currentRender.buf() << " " << slot.observer.getProgress();
+                } else {
+                    std::cout << "idle";
+                }
+                std::cout << std::endl;
+            }
+        };
+        // Stop the render of path on whichever engine has it, or drop it from the queue
+        auto cancelRender = [&](const std::string& path) {
+            for (auto& slot : renderSlots) {
+                if (slot->active && dl::String(path.c_str()) == slot->currentRender) {
+                    std::cout << "\n==\nStopping render" << path<< std::endl;
+                    slot->engine.stop();
+                    slot->active = false;
+                    slot->currentRender = "";
+                    return true;
+                }
+            }
+            return renderQueue.remove(path); // dequeue deletes
+        };
+        std::map<std::string, std::chrono::steady_clock::time_point> eventTimes; // first watcher event of queued files
+        auto recordQueueLatency = [&](const std::string& path) {
+            auto eventTime = eventTimes.find(path);
+            if (eventTime == eventTimes.end()) return;
+            vmaxStats().addQueueLatency(std::chrono::steady_clock::now() - eventTime->second);
+            eventTimes.erase(eventTime);
+        };
+        while (true) {
+            // Files that stopped changing move from the listener's debounce stage into fileQueue
+            std::chrono::milliseconds nextDue = global_ul->flushQuiet(&eventTimes);
+
+            // Append items from incoming queues to our persistent queues, push dedupes
             {
-                std::lock_guard<std::mutex> lock(fileQueueMutex);
                 std::string path;
                 while (fileQueue.pop(path)) {
-                    renderQueue.push(path);
+                    if (endsWith(path, ".vmax") || endsWith(path, ".zip")) {
+                        convertQueue.push(path);
+                    } else if (endsWith(path, ".bsz")) {
+                        {
+                            std::lock_guard<std::mutex> lock(conversionMutex);
+                            auto written = convertedOutputs.find(path);
+                            bool ownWrite = written != convertedOutputs.end() &&
+                                            std::chrono::steady_clock::now() - written->second < std::chrono::seconds(30);
+                            if (written != convertedOutputs.end()) convertedOutputs.erase(written);
+                            if (ownWrite) {
+                                // Already queued when its conversion finished, with the event time of its .vmax
+                                if (!renderQueue.contains(path)) eventTimes.erase(path);
+                                continue;
+                            }
+                        }
+                        renderQueue.push(path, renderRank(path));
+                    } else {
+                        eventTimes.erase(path);
+                    }
+                }
+                while (unfileQueue.pop(path)) {
+                    renderUnqueue.push(path);
                 }
-                fileQueue.clear();
             }
-            
+
+            // Deletes first, stop the active render or drop the file if it is still queued
             {
-                std::lock_guard<std::mutex> lock(unfileQueueMutex);
                 std::string path;
-                while (unfileQueue.pop(path)) {
-                    renderUnqueue.push(path);
+                while (renderUnqueue.pop(path)) { // pop all the deletes
+                    eventTimes.erase(path);
+                    if (incremental && (endsWith(path, ".vmax") || endsWith(path, ".zip"))) {
+                        std::lock_guard<std::mutex> lock(conversionMutex);
+                        forgetPreviousScene(path);
+                    }
+                    if (preview && path == previewPath) {
+                        previewState.reset(); // nothing left to update, the next one is a full build
+                    }
+                    cancelRender(path);
+                    if (endsWith(path, ".vmax") || endsWith(path, ".zip")) cancelRender(bszPathForVmax(path)); // the scene converted from it
+                    if (convertQueue.contains(path)) {
+                        convertQueue.remove(path);
+                    } else if (converting.count(path)) { // its result is dropped when it comes back
+                        std::lock_guard<std::mutex> lock(conversionMutex);
+                        cancelledConversions.insert(path);
+                    }
+                }
+            }
+
+            // Finished conversions go to the render stage
+            {
+                ConvertedScene converted;
+                while (convertedScenes.tryPop(converted)) {
+                    std::optional<std::chrono::steady_clock::time_point> eventTime;
+                    auto handedOut = converting.find(converted.vmaxPath);
+                    if (handedOut != converting.end()) {
+                        eventTime = handedOut->second;
+                        converting.erase(handedOut);
+                    }
+                    bool cancelled;
+                    {
+                        std::lock_guard<std::mutex> lock(conversionMutex);
+                        cancelled = cancelledConversions.erase(converted.vmaxPath) > 0;
+                    }
+                    if (!converted.error.empty()) {
+                        std::cout << "\n==" << "CONVERSION FAILED: " << converted.vmaxPath << " " << converted.error << "\n==" << std::endl;
+                    } else if (cancelled) {
+                        std::cout << "\n==" << "CONVERSION CANCELLED: " << converted.vmaxPath << "\n==" << std::endl;
+                    } else if (preview) {
+                        // Update the running preview in place when it shows the same .vmax, models come from modelCache
+                        dl::bella_sdk::Scene engineScene = previewSlot.engine.scene();
+                        dl::String belVmaxPath = dl::String(converted.vmaxPath.c_str());
+                        try {
+                            bool updated = previewState && previewPath == converted.vmaxPath &&
+                                           updateVmaxBellaScene(*previewState, belVmaxPath, convertOptions);
+                            if (!updated) {
+                                if (previewSlot.active) previewSlot.engine.stop();
+                                previewSlot.active = false;
+                                engineScene.clear();
+                                engineScene.loadDefs();
+                                previewState = std::make_unique<VmaxBellaScene>();
+                                buildVmaxScene(engineScene, belVmaxPath, convertOptions, previewState.get());
+                                previewPath = converted.vmaxPath;
+                                applyPreviewSettings(engineScene);
+                            }
+                            if (!previewSlot.active.exchange(true)) {
+                                previewSlot.engine.start();
+                            }
+                            previewSlot.currentRender = belVmaxPath;
+                            previewSlot.renderStarted = std::chrono::steady_clock::now();
+                            if (eventTime) vmaxStats().addQueueLatency(previewSlot.renderStarted - *eventTime);
+                            std::cout << "\n==" << (updated ? "PREVIEW UPDATED: " : "PREVIEW: ") << converted.vmaxPath << "\n==" << std::endl;
+                        } catch (const std::exception& e) {
+                            previewState.reset();
+                            std::cout << "\n==" << "PREVIEW FAILED: " << converted.vmaxPath << " " << e.what() << "\n==" << std::endl;
+                        }
+                        // No .bsz is written for a preview, free the scratch arena here instead of in writeBellaScene()
+                        vmaxThreadArena().release();
+                    } else {
+                        std::cout << "\n==" << "CONVERTED: " << converted.bszPath << "\n==" << std::endl;
+                        // Counted when an engine starts it, see recordQueueLatency
+                        if (eventTime) {
+                            eventTimes[converted.bszPath] = *eventTime;
+                        } else {
+                            eventTimes.erase(converted.bszPath);
+                        }
+                        renderQueue.push(converted.bszPath, renderRank(converted.bszPath));
+                    }
+                    reportStats();
+                }
+            }
+
+            // Hand queued .vmax and .zip to the conversion workers while they have room
+            // A file re-exported while it converts waits for that conversion to come back,
+            // the files queued behind it go ahead
+            auto isConverting = [&](const std::string& path) { return converting.count(path) > 0; };
+            {
+                std::string path;
+                while (!convertJobs.full() && convertQueue.popUnless(path, isConverting)) {
+                    auto eventTime = eventTimes.find(path);
+                    auto& handedOut = converting[path];
+                    if (eventTime != eventTimes.end()) {
+                        handedOut = eventTime->second;
+                        eventTimes.erase(eventTime);
+                    }
+                    convertJobs.push(path); // only this thread pushes, so it does not block
                 }
-                unfileQueue.clear();
             }
 
             // Process items from the persistent queues one at a time
@@ -433,60 +959,86 @@ int DL_main(dl::Args& args) {
             // while the purpos eof the is main loop is event processing
 
             // Process the files without holding the mutex
-            bool expected = false;
-            
-            // This is an atomic operation that does two things at once:
-            // 1. Checks if active_render equals expected (false)
-            // 2. If they are equal, sets active_render to true
-            // 
-            // The operation is atomic, meaning no other thread can interfere
-            // between the check and the set. This prevents two threads from
-            // both thinking they can start rendering at the same time.
-            //
-            // Returns true if the exchange was successful (we got the render slot)
-            // Returns false if active_render was already true (someone else is rendering)
-            dl::String currentRender;
-            dl::String belPath;
-            if (!renderQueue.empty()) {
-                if (active_render.compare_exchange_strong(expected, true)) {
+            // Every engine with a free slot takes the queued .bsz with the lowest renderRank()
+            bool renderStatusChanged = false;
+            for (size_t slotIndex = 0; slotIndex < renderSlots.size(); slotIndex++) {
+                RenderSlot& slot = *renderSlots[slotIndex];
+                // A render that stopped by itself, noise target reached or done
+                if (!slot.active && !slot.currentRender.isEmpty()) {
+                    slot.currentRender = "";
+                    renderStatusChanged = true;
+                }
+                if (renderQueue.empty() || !rendersBsz(slotIndex)) continue;
+
+                // This is an atomic operation that does two things at once:
+                // 1. Checks if the slot's active flag equals expected (false)
+                // 2. If they are equal, sets it to true
+                //
+                // The operation is atomic, meaning no other thread can interfere
+                // between the check and the set. This prevents two threads from
+                // both thinking they can start rendering at the same time.
+                //
+                // Returns true if the exchange was successful (we got the render slot)
+                // Returns false if the flag was already true (this engine is rendering)
+                bool expected = false;
+                if (slot.active.compare_exchange_strong(expected, true)) {
                     std::string path;
                     renderQueue.pop(path);
-                    belPath = dl::String(path.c_str());
-                    if (belPath.endsWith(".bsz")) {
-                        engine.loadScene(belPath);
-                        engine.scene().camera()["resolution"] = dl::Vec2 {200, 200};
-                        engine.start();
-                        currentRender = belPath;
-                        std::cout << "\n==" << "RENDERING: " << path << "\n==" << std::endl;
-                    } else if (belPath.endsWith(".vmax")) {
-                        convertVmaxToBella(belPath);
-                    }
-                } else {
-                    std::string path;
-                    while (renderUnqueue.pop(path)) { // pop all the deletes
-                        if (dl::String(path.c_str()) == currentRender) {
-                            std::cout << "\n==\nStopping render" << path<< std::endl;
-                            engine.stop();
-                            active_render = false;
-                        } else if (renderQueue.contains(path)) { // dequeue deletes
-                            renderQueue.remove(path);
-                        } 
+                    recordQueueLatency(path);
+                    dl::String belPath = dl::String(path.c_str());
+                    slot.engine.loadScene(belPath);
+                    if (&slot == &previewSlot) {
+                        previewState.reset(); // the engine's scene was replaced
+                        previewPath.clear();
                     }
+                    applyPreviewSettings(slot.engine.scene());
+                    slot.observer.setLabel(renderSlots.size() > 1 ? "[" + std::to_string(slotIndex + 1) + "] " : "");
+                    slot.engine.start();
+                    slot.currentRender = belPath;
+                    slot.renderStarted = std::chrono::steady_clock::now();
+                    renderStatusChanged = true;
+                    std::cout << "\n==" << "RENDERING: " << path << "\n==" << std::endl;
                 }
             }
 
-
-
             //std::cout << "Render Queue Size: " << renderQueue.size() << std::endl;
             //std::cout << "Render Unqueue Size: " << renderUnqueue.size() << std::endl;
 
+            // Time budget of each running render, see --preview-time
+            for (auto& slot : renderSlots) {
+                if (!slot->active || previewTimeBudget.count() <= 0) continue;
+                auto renderedFor = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - slot->renderStarted);
+                if (renderedFor >= previewTimeBudget) {
+                    std::cout << "\n==" << "TIME BUDGET REACHED: " << slot->currentRender.buf() << "\n==" << std::endl;
+                    slot->engine.stop();
+                    slot->active = false;
+                } else {
+                    nextDue = std::min(nextDue, previewTimeBudget - renderedFor);
+                }
+            }
+            if (renderStatusChanged) printRenderStatus();
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(900));
+            // Sleep until the watcher queues a file, a render stops, a conversion finishes or a held file is due
+            // Loop straight away while a free render slot or conversion worker could take a queued file
+            bool freeSlot = false;
+            for (size_t slotIndex = 0; slotIndex < renderSlots.size(); slotIndex++) {
+                if (!renderSlots[slotIndex]->active && rendersBsz(slotIndex)) freeSlot = true;
+            }
+            bool canRender = freeSlot && !renderQueue.empty();
+            // Whatever is left in convertQueue waits for a worker or for its own conversion, both wake us
+            if (!canRender) {
+                if (nextDue == std::chrono::milliseconds::max()) {
+                    watchWake.wait();
+                } else {
+                    watchWake.waitFor(nextDue);
+                }
+            }
         }
     }
 
     return 0;
 }
+#endif // VMAXTUI_NO_MAIN
 
 
 
@@ -583,6 +1135,163 @@ dl::bella_sdk::Node essentialsToScene(dl::bella_sdk::Scene& belScene) {
 }
 
 
+// quickMaterial settings of one material/color bucket
+// Models sharing a palette and materials end up with equal settings, see internVoxelMaterial()
+struct BellaVoxelMaterial {
+    std::string type;
+    double roughness = -1.0;     // -1 leaves the quickMaterial default
+    double transmission = -1.0;
+    double emitterEnergy = -1.0;
+    double liquidDepth = -1.0;
+    double glassDepth = -1.0;
+    double ior = -1.0;
+    dl::Rgba color;              // linear
+
+    // Every setting exactly, equal keys are interchangeable materials
+    std::string key() const {
+        char text[256];
+        snprintf(text, sizeof(text), "%s %a %a %a %a %a %a %a %a %a %a", type.c_str(), roughness, transmission, emitterEnergy,
+                 liquidDepth, glassDepth, ior, color.r, color.g, color.b, color.a);
+        return text;
+    }
+};
+
+// Pick the Bella material type and settings for a vmax material and palette color
+// @param color - palette index 1-255, 0 is no voxel
+BellaVoxelMaterial bellaVoxelMaterial(int material, int color, const std::vector<VmaxRGBA>& vmaxPalette, const std::array<VmaxMaterial, 8>& vmaxMaterial) {
+    BellaVoxelMaterial belMaterial;
+    if(material==7) {
+        belMaterial.type = "liquid";
+        //belMaterial.roughness = vmaxMaterial[material].roughness * 100.0f;
+        belMaterial.liquidDepth = 100.0f;
+        belMaterial.ior = 1.11f;
+    } else if(material==6 || vmaxPalette[color-1].a < 255) {
+        belMaterial.type = "glass";
+        belMaterial.roughness = vmaxMaterial[material].roughness * 100.0f;
+        belMaterial.glassDepth = 200.0f;
+    } else if(vmaxMaterial[material].metalness > 0.1f) {
+        belMaterial.type = "metal";
+        belMaterial.roughness = vmaxMaterial[material].roughness * 100.0f;
+    } else if(vmaxMaterial[material].transmission > 0.0f) {
+        belMaterial.type = "dielectric";
+        belMaterial.transmission = vmaxMaterial[material].transmission;
+    } else if(vmaxMaterial[material].emission > 0.0f) {
+        belMaterial.type = "emitter";
+        belMaterial.emitterEnergy = vmaxMaterial[material].emission*500.0f;
+    } else {
+        belMaterial.type = "plastic";
+        belMaterial.roughness = vmaxMaterial[material].roughness * 100.0f;
+    }
+    // Convert 0-255 to 0-1 , remember to -1 color index becuase voxelmax needs 0 to indicate no voxel
+    double bellaR = static_cast<double>(vmaxPalette[color-1].r)/255.0;
+    double bellaG = static_cast<double>(vmaxPalette[color-1].g)/255.0;
+    double bellaB = static_cast<double>(vmaxPalette[color-1].b)/255.0;
+    double bellaA = static_cast<double>(vmaxPalette[color-1].a)/255.0;
+    belMaterial.color = dl::Rgba{ // convert sRGB to linear
+        srgbToLinear(bellaR), 
+        srgbToLinear(bellaG), 
+        srgbToLinear(bellaB), 
+        bellaA // alpha is already linear
+    }; // colors ready to use in Bella
+    return belMaterial;
+}
+
+// One quickMaterial node per distinct set of settings in a scene
+// The node is named after a hash of the settings, so an equal material made for any earlier model,
+// or an earlier build of the same scene, is found with findNode() instead of tracked on the side
+// @return - the existing or new material node
+dl::bella_sdk::Node internVoxelMaterial(dl::bella_sdk::Scene& belScene, const BellaVoxelMaterial& settings) {
+    std::string key = settings.key();
+    char name[32];
+    snprintf(name, sizeof(name), "vmaxMat%016llx",
+             (unsigned long long)vmaxHashBytes(reinterpret_cast<const uint8_t*>(key.data()), key.size(), 0));
+    dl::bella_sdk::Node belMaterial = belScene.findNode(name);
+    if (belMaterial) {
+        vmaxStats().materialsShared++;
+        return belMaterial;
+    }
+
+    belMaterial = belScene.createNode("quickMaterial", name);
+    vmaxStats().materials++;
+    belMaterial["type"] = settings.type.c_str();
+    if (settings.roughness >= 0.0) belMaterial["roughness"] = settings.roughness;
+    if (settings.transmission >= 0.0) belMaterial["transmission"] = settings.transmission;
+    if (settings.liquidDepth >= 0.0) belMaterial["liquidDepth"] = settings.liquidDepth;
+    if (settings.glassDepth >= 0.0) belMaterial["glassDepth"] = settings.glassDepth;
+    if (settings.ior >= 0.0) belMaterial["ior"] = settings.ior;
+    if (settings.emitterEnergy >= 0.0) {
+        belMaterial["emitterUnit"] = "radiance";
+        belMaterial["emitterEnergy"] = settings.emitterEnergy;
+    }
+    belMaterial["color"] = settings.color;
+    return belMaterial;
+}
+
+// Instancer transforms for every bucket of a model, indexed like vmaxModel.bucketKeys
+// Arrays are sized once from the bucket and then written in place, culling first counts the
+// visible voxels of each bucket. Both passes split the voxels into slices spread over jobs threads
+// @param opaqueOccupancy - optional, voxels hidden by it are left out, see buildOpaqueOccupancy()
+// @param culledCount - incremented by the number of voxels left out
+std::vector<dl::ds::Vector<dl::Mat4f>> buildInstanceXforms(const VmaxModel& vmaxModel, const VmaxOccupancy* opaqueOccupancy, unsigned jobs, size_t& culledCount) {
+    const size_t sliceSize = 64 * 1024;
+    struct Slice { size_t bucket; uint32_t first, last; };
+    std::vector<Slice> slices;
+    size_t bucketCount = vmaxModel.bucketKeys.size();
+    for (size_t b = 0; b < bucketCount; b++) {
+        for (uint32_t first = vmaxModel.bucketOffsets[b]; first < vmaxModel.bucketOffsets[b + 1]; first += sliceSize) {
+            slices.push_back(Slice{b, first, static_cast<uint32_t>(std::min<size_t>(first + sliceSize, vmaxModel.bucketOffsets[b + 1]))});
+        }
+    }
+    auto isVisible = [&](uint32_t packedVoxel) {
+        if (!opaqueOccupancy) return true;
+        uint32_t voxelX, voxelY, voxelZ;
+        unpackVoxelPosition(packedVoxel, voxelX, voxelY, voxelZ);
+        return !vmaxVoxelIsHidden(*opaqueOccupancy, voxelX, voxelY, voxelZ);
+    };
+
+    // Where each slice starts writing in its bucket's array
+    std::vector<size_t> sliceStart(slices.size(), 0);
+    std::vector<size_t> sliceVisible(slices.size(), 0);
+    if (opaqueOccupancy) {
+        runParallel(slices.size(), jobs, [&](size_t i) {
+            size_t visible = 0;
+            for (uint32_t v = slices[i].first; v < slices[i].last; v++) {
+                visible += isVisible(vmaxModel.positions[v]) ? 1 : 0;
+            }
+            sliceVisible[i] = visible;
+        });
+    } else {
+        for (size_t i = 0; i < slices.size(); i++) sliceVisible[i] = slices[i].last - slices[i].first;
+    }
+    std::vector<size_t> bucketSizes(bucketCount, 0);
+    for (size_t i = 0; i < slices.size(); i++) {
+        sliceStart[i] = bucketSizes[slices[i].bucket];
+        bucketSizes[slices[i].bucket] += sliceVisible[i];
+        culledCount += (slices[i].last - slices[i].first) - sliceVisible[i];
+    }
+
+    std::vector<dl::ds::Vector<dl::Mat4f>> bucketXforms(bucketCount);
+    for (size_t b = 0; b < bucketCount; b++) {
+        bucketXforms[b].resize(bucketSizes[b]);
+    }
+    runParallel(slices.size(), jobs, [&](size_t i) {
+        dl::Mat4f* out = bucketXforms[slices[i].bucket].data() + sliceStart[i];
+        for (uint32_t v = slices[i].first; v < slices[i].last; v++) {
+            uint32_t packedVoxel = vmaxModel.positions[v];
+            if (!isVisible(packedVoxel)) continue;
+            uint32_t voxelX, voxelY, voxelZ;
+            unpackVoxelPosition(packedVoxel, voxelX, voxelY, voxelZ);
+            *out++ = dl::Mat4f{  1, 0, 0, 0, 
+                                 0, 1, 0, 0, 
+                                 0, 0, 1, 0, 
+                                 static_cast<float>(voxelX),
+                                 static_cast<float>(voxelY),
+                                 static_cast<float>(voxelZ), 1 };
+        }
+    });
+    return bucketXforms;
+}
+
 // Only add the canonical model to the scene
 // We'll use xforms to instance the model
 // Each model is stores in contentsN.vmaxb as a lzfe compressed plist
@@ -592,12 +1301,13 @@ dl::bella_sdk::Node essentialsToScene(dl::bella_sdk::Scene& belScene) {
 // The datastream contains the voxels for the snapshot
 // The voxels are stored in chunks, each chunk is 8x8x8 voxels
 // The chunks are stored in a morton order
-dl::bella_sdk::Node addModelToScene(dl::bella_sdk::Scene& belScene, dl::bella_sdk::Node& belWorld, const VmaxModel& vmaxModel, const std::vector<VmaxRGBA>& vmaxPalette, const std::array<VmaxMaterial, 8>& vmaxMaterial) {
+dl::bella_sdk::Node addModelToScene(dl::bella_sdk::Scene& belScene, dl::bella_sdk::Node& belWorld, const VmaxModel& vmaxModel, const std::vector<VmaxRGBA>& vmaxPalette, const std::array<VmaxMaterial, 8>& vmaxMaterial, const ConvertOptions& options, std::vector<dl::bella_sdk::Node>* createdNodes, std::set<std::string>* usedMaterials) {
     // Create Bella scene nodes for each voxel
     int i = 0;
     dl::String modelName = dl::String(vmaxModel.vmaxbFileName.c_str());
     dl::String canonicalName = modelName.replace(".vmaxb", "");
     dl::bella_sdk::Node belCanonicalNode;
+    VmaxStatTimer buildTimer(vmaxStats().sceneBuildNanos);
     {
         dl::bella_sdk::Scene::EventScope es(belScene);
 
@@ -607,81 +1317,73 @@ dl::bella_sdk::Node addModelToScene(dl::bella_sdk::Scene& belScene, dl::bella_sd
         auto belVoxelForm = belScene.findNode("oomerVoxelXform");
         auto belLiqVoxelForm = belScene.findNode("oomerLiqVoxelXform");
 
-        auto modelXform = belScene.createNode("xform", canonicalName, canonicalName);
-        modelXform["steps"][0]["xform"] = dl::Mat4 {1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1};
-        for (const auto& [material, colorID] : vmaxModel.getUsedMaterialsAndColors()) {
-            for (int color : colorID) {
-                auto belInstancer  = belScene.createNode("instancer",
-                                canonicalName + dl::String("Material") + dl::String(material) + dl::String("Color") + dl::String(color));
-                auto xformsArray = dl::ds::Vector<dl::Mat4f>();
-                belInstancer["steps"][0]["xform"] = dl::Mat4 {1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1};
-                belInstancer.parentTo(modelXform);
+        // A coarse level of detail is built in its own units, the model xform scales it back up
+        // Voxel x of level N covers x*2^N .. x*2^N + 2^N-1, so its center is moved by (2^N-1)/2
+        VmaxModel lodModel(vmaxModel.vmaxbFileName);
+        if (options.lod > 0) lodModel = buildVmaxLod(vmaxModel, options.lod);
+        const VmaxModel& buildModel = options.lod > 0 ? lodModel : vmaxModel;
+        double lodScale = double(1 << std::max(0, options.lod));
+        double lodOffset = (lodScale - 1.0) * 0.5;
 
-                auto belMaterial  = belScene.createNode("quickMaterial",
-                                canonicalName + dl::String("vmaxMat") + dl::String(material) + dl::String("Color") + dl::String(color));
+        auto modelXform = belScene.createNode("xform", canonicalName, canonicalName);
+        modelXform["steps"][0]["xform"] = dl::Mat4 {lodScale,0,0,0,0,lodScale,0,0,0,0,lodScale,0,lodOffset,lodOffset,lodOffset,1};
+        // Every node made here, so an incremental update can delete the model again
+        auto remember = [createdNodes](dl::bella_sdk::Node node) {
+            if (createdNodes) createdNodes->push_back(node);
+            return node;
+        };
+        remember(modelXform);
+
+        // Optional pass dropping voxels buried inside opaque volumes, they can never be seen
+        // Meshing needs the same occupancy to find visible faces
+        VmaxOccupancy opaqueOccupancy;
+        if (options.cullHidden || options.meshGeometry) {
+            opaqueOccupancy = buildOpaqueOccupancy(buildModel, vmaxPalette);
+        }
+        std::vector<VmaxQuad> quads; // reused per material/color
+        size_t culledCount = 0;
+        // Instance transforms of every bucket, sized up front and filled on all cores
+        std::vector<dl::ds::Vector<dl::Mat4f>> bucketXforms;
+        if (!options.meshGeometry) {
+            bucketXforms = buildInstanceXforms(buildModel, options.cullHidden ? &opaqueOccupancy : nullptr, options.jobs, culledCount);
+        }
 
+        for (const auto& [material, colorID] : buildModel.getUsedMaterialsAndColors()) {
+            for (int color : colorID) {
+                int bucket = buildModel.findBucket(material, color);
+                if (bucket < 0) continue; // not finalized, nothing to instance
+                if (!options.meshGeometry && bucketXforms[bucket].size() == 0) continue; // whole bucket is hidden
+                if (options.meshGeometry) {
+                    buildGreedyQuads(buildModel, bucket, opaqueOccupancy, quads);
+                    if (quads.empty()) continue; // no visible faces
+                }
 
-                if(material==7) {
-                    belMaterial["type"] = "liquid";
-                    //belMaterial["roughness"] = vmaxMaterial[material].roughness * 100.0f;
-                    belMaterial["liquidDepth"] = 100.0f;
-                    belMaterial["ior"] = 1.11f;
-                } else if(material==6 || vmaxPalette[color-1].a < 255) {
-                    belMaterial["type"] = "glass";
-                    belMaterial["roughness"] = vmaxMaterial[material].roughness * 100.0f;
-                    belMaterial["glassDepth"] = 200.0f;
-                } else if(vmaxMaterial[material].metalness > 0.1f) {
-                    belMaterial["type"] = "metal";
-                    belMaterial["roughness"] = vmaxMaterial[material].roughness * 100.0f;
-                } else if(vmaxMaterial[material].transmission > 0.0f) {
-                    belMaterial["type"] = "dielectric";
-                    belMaterial["transmission"] = vmaxMaterial[material].transmission;
-                } else if(vmaxMaterial[material].emission > 0.0f) {
-                    belMaterial["type"] = "emitter";
-                    belMaterial["emitterUnit"] = "radiance";
-                    std::cout << "vmaxMaterial[material].emission: " << vmaxMaterial[material].emission << std::endl;
-                    std::cout << "belMaterial[" << belMaterial["type"].asString() << "]" << std::endl;
-                    belMaterial["emitterEnergy"] = vmaxMaterial[material].emission*500.0f;
-                } else {
-                    belMaterial["type"] = "plastic";
-                    belMaterial["roughness"] = vmaxMaterial[material].roughness * 100.0f;
+                // Equal settings share one node across all models of the scene, so it is not remembered
+                // with this model and survives an incremental update of it, usedMaterials tells when no model needs it
+                auto belMaterial = internVoxelMaterial(belScene, bellaVoxelMaterial(material, color, vmaxPalette, vmaxMaterial));
+                if (usedMaterials) usedMaterials->insert(belMaterial.name().buf());
+
+                dl::String bucketName = canonicalName + dl::String("Material") + dl::String(material) + dl::String("Color") + dl::String(color);
+                if (options.meshGeometry) {
+                    // One mesh of greedy merged visible faces instead of an instance per voxel
+                    auto belBucketXform = remember(belScene.createNode("xform", bucketName, bucketName));
+                    belBucketXform["steps"][0]["xform"] = dl::Mat4 {1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1};
+                    belBucketXform["material"] = belMaterial;
+                    belBucketXform.parentTo(modelXform);
+                    remember(addQuadMeshToScene(belScene, bucketName + dl::String("Mesh"), quads)).parentTo(belBucketXform);
+                    vmaxStats().buckets++;
+                    vmaxStats().meshQuads += quads.size();
+                    continue;
                 }
+
+                auto belInstancer  = remember(belScene.createNode("instancer", bucketName));
+                belInstancer["steps"][0]["xform"] = dl::Mat4 {1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1};
+                belInstancer.parentTo(modelXform);
                 belInstancer["material"] = belMaterial;
-                // Convert 0-255 to 0-1 , remember to -1 color index becuase voxelmax needs 0 to indicate no voxel
-                double bellaR = static_cast<double>(vmaxPalette[color-1].r)/255.0;
-                double bellaG = static_cast<double>(vmaxPalette[color-1].g)/255.0;
-                double bellaB = static_cast<double>(vmaxPalette[color-1].b)/255.0;
-                double bellaA = static_cast<double>(vmaxPalette[color-1].a)/255.0;
-                belMaterial["color"] = dl::Rgba{ // convert sRGB to linear
-                    srgbToLinear(bellaR), 
-                    srgbToLinear(bellaG), 
-                    srgbToLinear(bellaB), 
-                    bellaA // alpha is already linear
-                }; // colors ready to use in Bella
-
-                // Get all voxels for this material/color combination
-                const std::vector<VmaxVoxel>& voxelsOfType = vmaxModel.getVoxels(material, color);
-                int showchunk =0;
-
-                // Right now we group voxels by MatCol ie Mat0Col2
-                // But voxels are stored in chunks with many colors 
-                // Since we aren't grouping voxels in chunks, we need to traverse the voxels 
-                // and offset each voxel by the morton decode of chunk index
-                for (const auto& eachvoxel : voxelsOfType) {
-                    // Get chunk coordinates and world origin
-                    uint32_t _tempx, _tempy, _tempz;
-                    decodeMorton3DOptimized(eachvoxel.chunkID, _tempx, _tempy, _tempz); // index IS the morton code
-                    int worldOffsetX = _tempx * 24; // get world loc within 256x256x256 grid
-                    int worldOffsetY = _tempy * 24; // Don't know why we need to multiply by 24
-                    int worldOffsetZ = _tempz * 24; // use to be 32
-                    xformsArray.push_back( dl::Mat4f{  1, 0, 0, 0, 
-                                                        0, 1, 0, 0, 
-                                                        0, 0, 1, 0, 
-                                                        static_cast<float>(eachvoxel.x + worldOffsetX),
-                                                        static_cast<float>(eachvoxel.y + worldOffsetY),
-                                                        static_cast<float>(eachvoxel.z + worldOffsetZ), 1 });
-                }
-                belInstancer["steps"][0]["instances"] = xformsArray;
+
+                belInstancer["steps"][0]["instances"] = bucketXforms[bucket];
+                vmaxStats().addBucket(bucketXforms[bucket].size());
+                bucketXforms[bucket] = dl::ds::Vector<dl::Mat4f>(); // the scene has its copy, keep peak memory down
                 if(material==7) {
                     belLiqVoxel.parentTo(belInstancer);
                 } else {
@@ -692,13 +1394,75 @@ dl::bella_sdk::Node addModelToScene(dl::bella_sdk::Scene& belScene, dl::bella_sd
                 }
             }
         }
+        if (options.cullHidden && !options.meshGeometry) {
+            std::cout << canonicalName.buf() << ": culled " << culledCount << " of " 
+                      << buildModel.getTotalVoxelCount() << " hidden voxels" << std::endl;
+        }
         return modelXform;
     }
     return dl::bella_sdk::Node();
 }
 
 
-dl::bella_sdk::Scene convertVmaxToBella( const dl::String& vmaxDirName)
+// Turn greedy meshed quads into a Bella mesh node, same layout as resources/smoothcube.h
+// Voxels are centered on their integer position so faces sit half a voxel away
+// @param belScene - the scene to create the mesh in
+// @param meshName - node name
+// @param quads - output of buildGreedyQuads()
+// @return - the mesh node, not parented
+dl::bella_sdk::Node addQuadMeshToScene(dl::bella_sdk::Scene& belScene, const dl::String& meshName, const std::vector<VmaxQuad>& quads) {
+    auto belMesh = belScene.createNode("mesh", meshName, meshName);
+    belMesh["channels"][0] = "st";
+    belMesh["optimized"] = false;
+
+    dl::ds::Vector<dl::Vec4u> polygons;
+    dl::ds::Vector<dl::Vec3f> normals;
+    dl::ds::Vector<dl::Vec2f> uvs;
+    dl::ds::Vector<dl::Pos3f> points;
+    uint32_t vertex = 0;
+    for (const VmaxQuad& quad : quads) {
+        int u = (quad.axis + 1) % 3;
+        int v = (quad.axis + 2) % 3;
+        float plane = quad.slice + (quad.positive ? 0.5f : -0.5f);
+        float u0 = quad.u0 - 0.5f, u1 = u0 + quad.w;
+        float v0 = quad.v0 - 0.5f, v1 = v0 + quad.h;
+        // u x v points along +axis, reverse the winding for faces pointing along -axis
+        float corners[4][2] = { {u0, v0}, {u1, v0}, {u1, v1}, {u0, v1} };
+        float normal[3] = {0, 0, 0};
+        normal[quad.axis] = quad.positive ? 1.0f : -1.0f;
+        for (int c = 0; c < 4; c++) {
+            int corner = quad.positive ? c : 3 - c;
+            float p[3];
+            p[quad.axis] = plane;
+            p[u] = corners[corner][0];
+            p[v] = corners[corner][1];
+            points.push_back(dl::Pos3f{p[0], p[1], p[2]});
+            normals.push_back(dl::Vec3f{normal[0], normal[1], normal[2]});
+            uvs.push_back(dl::Vec2f{corners[corner][0] - u0, corners[corner][1] - v0}); // one uv unit per voxel
+        }
+        polygons.push_back(dl::Vec4u{vertex, vertex + 1, vertex + 2, vertex + 3});
+        vertex += 4;
+    }
+    belMesh["polygons"] = polygons;
+    belMesh["steps"][0]["normals"] = normals;
+    belMesh["steps"][0]["uvs"] = uvs;
+    belMesh["steps"][0]["points"] = points;
+    return belMesh;
+}
+
+// Bella xform of a scene.json group or object transform
+dl::Mat4 vmaxTransformToBella(const VmaxSceneTransform& transform) {
+    VmaxMatrix4x4 objectMat4 = vmaxTransformMatrix(transform);
+    return dl::Mat4({
+        objectMat4.m[0][0], objectMat4.m[0][1], objectMat4.m[0][2], objectMat4.m[0][3],
+        objectMat4.m[1][0], objectMat4.m[1][1], objectMat4.m[1][2], objectMat4.m[1][3],
+        objectMat4.m[2][0], objectMat4.m[2][1], objectMat4.m[2][2], objectMat4.m[2][3],
+        objectMat4.m[3][0], objectMat4.m[3][1], objectMat4.m[3][2], objectMat4.m[3][3]
+        });
+}
+
+// @param keepState - optional, filled with the scene and what it was built from for updateVmaxBellaScene()
+dl::bella_sdk::Scene convertVmaxToBella( const dl::String& vmaxDirName, const ConvertOptions& options, VmaxBellaScene* keepState)
 {
     //dl::String bszName;
     //bszName = vmaxDirName.replace(".vmax", ".bsz");
@@ -706,6 +1470,34 @@ dl::bella_sdk::Scene convertVmaxToBella( const dl::String& vmaxDirName)
     // Create a new scene
     dl::bella_sdk::Scene belScene;
     belScene.loadDefs();
+    buildVmaxScene(belScene, vmaxDirName, options, keepState);
+    return belScene;
+}
+
+// Decode every model of a .vmax into modelCache without touching any Bella scene
+// Lets a worker thread do the slow part of a conversion for a scene built on another thread
+void prefetchVmaxModels(const dl::String& vmaxDirName, const ConvertOptions& options)
+{
+    VmaxZipMount zipMount(vmaxDirName.buf());
+    VmaxScene vmaxScene;
+    if (!vmaxScene.parse((vmaxDirName+"/scene.json").buf())) {
+        throw std::runtime_error(std::string("Failed to read scene.json in: ") + vmaxDirName.buf());
+    }
+    std::string vmaxDir = vmaxDirName.buf();
+    std::vector<bool> objectInRegion;
+    std::vector<VmaxDecodeOptions> decodeOptions = regionDecodeOptions(vmaxScene, options, objectInRegion);
+    runParallel(vmaxScene.contents.size(), options.jobs, [&](size_t contentIndex) {
+        if (!decodeOptions[contentIndex].decodesAnyChunk()) return;
+        const JsonModelInfo& files = vmaxScene.contents[contentIndex].files;
+        modelCache.decode(vmaxDir, files.dataFile, files, decodeOptions[contentIndex]);
+    });
+}
+
+// Build the Bella nodes of a .vmax into an existing scene, defs must already be loaded
+// @param belScene - empty scene, or the engine's scene for a live preview
+// @param keepState - optional, filled with the scene and what it was built from for updateVmaxBellaScene()
+void buildVmaxScene(dl::bella_sdk::Scene& belScene, const dl::String& vmaxDirName, const ConvertOptions& options, VmaxBellaScene* keepState)
+{
     auto belWorld = belScene.world(true);
 
     // scene.json is the toplevel file that hierarchically defines the scene
@@ -718,56 +1510,36 @@ dl::bella_sdk::Scene convertVmaxToBella( const dl::String& vmaxDirName)
     //  - reference to a paletteN.settings.vmaxpsb (plist file) that defines the 8 materials used in the "model"
     // In scenegraph parlance a group is a xform, a object is a transform with a child geometry 
     // multiple objects can point to the same model creating what is known as an instance
-    JsonVmaxSceneParser vmaxSceneParser;
-    vmaxSceneParser.parseScene((vmaxDirName+"/scene.json").buf());
+    // Read as flat records with interned ids, node names are made once while parsing, see VmaxScene
+    // A .vmax.zip is read in place, its entries stand in for the files of a .vmax directory
+    VmaxZipMount zipMount(vmaxDirName.buf());
+    VmaxScene vmaxScene;
+    if (!vmaxScene.parse((vmaxDirName+"/scene.json").buf())) {
+        throw std::runtime_error(std::string("Failed to read scene.json in: ") + vmaxDirName.buf());
+    }
 
     #ifdef _DEBUG
-        vmaxSceneParser.printSummary();
+        std::cout << "Groups: " << vmaxScene.groups.size() << " Objects: " << vmaxScene.objects.size() 
+                  << " Models: " << vmaxScene.contents.size() << std::endl;
     #endif
-    std::map<std::string, JsonGroupInfo> jsonGroups = vmaxSceneParser.getGroups();
-    std::map<dl::String, dl::bella_sdk::Node> belGroupNodes; // Map of UUID to bella node
-    std::map<dl::String, dl::bella_sdk::Node> belCanonicalNodes; // Map of UUID to bella node
+    std::vector<dl::bella_sdk::Node> belGroupNodes(vmaxScene.groups.size()); // indexed like vmaxScene.groups
+    std::vector<dl::bella_sdk::Node> belCanonicalNodes(vmaxScene.contents.size()); // indexed like vmaxScene.contents
 
     // First pass to create all the Bella nodes for the groups
-    for (const auto& [groupName, groupInfo] : jsonGroups) { 
-        dl::String belGroupUUID = dl::String(groupName.c_str());
-        belGroupUUID = belGroupUUID.replace("-", "_"); // Make sure the group name is valid for a Bella node name
-        belGroupUUID = "_" + belGroupUUID; // Make sure the group name is valid for a Bella node name
-        belGroupNodes[belGroupUUID] = belScene.createNode("xform", belGroupUUID, belGroupUUID); // Create a Bella node for the group
-
-
-        VmaxMatrix4x4 objectMat4 = combineVmaxTransforms(groupInfo.rotation[0], 
-                                          groupInfo.rotation[1], 
-                                          groupInfo.rotation[2], 
-                                          groupInfo.rotation[3],
-                                          groupInfo.position[0], 
-                                          groupInfo.position[1], 
-                                          groupInfo.position[2], 
-                                          groupInfo.scale[0], 
-                                          groupInfo.scale[1], 
-                                          groupInfo.scale[2]);
-
-        belGroupNodes[belGroupUUID]["steps"][0]["xform"] = dl::Mat4({
-            objectMat4.m[0][0], objectMat4.m[0][1], objectMat4.m[0][2], objectMat4.m[0][3],
-            objectMat4.m[1][0], objectMat4.m[1][1], objectMat4.m[1][2], objectMat4.m[1][3],
-            objectMat4.m[2][0], objectMat4.m[2][1], objectMat4.m[2][2], objectMat4.m[2][3],
-            objectMat4.m[3][0], objectMat4.m[3][1], objectMat4.m[3][2], objectMat4.m[3][3]
-            });
+    for (size_t groupIndex = 0; groupIndex < vmaxScene.groups.size(); groupIndex++) { 
+        const VmaxSceneGroup& group = vmaxScene.groups[groupIndex];
+        dl::String belGroupUUID = group.nodeName.c_str();
+        belGroupNodes[groupIndex] = belScene.createNode("xform", belGroupUUID, belGroupUUID); // Create a Bella node for the group
+        belGroupNodes[groupIndex]["steps"][0]["xform"] = vmaxTransformToBella(group.transform);
     }
 
     // json file is allowed the parent to be defined after the child, requiring us to create all the bella nodes before we can parent them
-    for (const auto& [groupName, groupInfo] : jsonGroups) { 
-        dl::String belGroupUUID = dl::String(groupName.c_str());
-        belGroupUUID = belGroupUUID.replace("-", "_");
-        belGroupUUID = "_" + belGroupUUID;
-        if (groupInfo.parentId == "") {
-            belGroupNodes[belGroupUUID].parentTo(belWorld); // Group without a parent is a child of the world
+    for (size_t groupIndex = 0; groupIndex < vmaxScene.groups.size(); groupIndex++) { 
+        int32_t parent = vmaxScene.groups[groupIndex].parent;
+        if (parent < 0) {
+            belGroupNodes[groupIndex].parentTo(belWorld); // Group without a parent is a child of the world
         } else {
-            dl::String belPPPGroupUUID = dl::String(groupInfo.parentId.c_str());
-            belPPPGroupUUID = belPPPGroupUUID.replace("-", "_");
-            belPPPGroupUUID = "_" + belPPPGroupUUID;
-            dl::bella_sdk::Node myParentGroup = belGroupNodes[belPPPGroupUUID]; // Get bella obj
-            belGroupNodes[belGroupUUID].parentTo(myParentGroup); // Group underneath a group
+            belGroupNodes[groupIndex].parentTo(belGroupNodes[parent]); // Group underneath a group
         }
     }
 
@@ -777,142 +1549,351 @@ dl::bella_sdk::Scene convertVmaxToBella( const dl::String& vmaxDirName)
     //   "model2.vmaxb": [instance1, ..., instance30],
     //   "model3.vmaxb": [instance1, ..., instance20]
     // This loop runs only 3 times (once per unique model), not 100 times (once per instance)
-    
-    auto modelVmaxbMap = vmaxSceneParser.getModelContentVMaxbMap(); 
-    std::vector<VmaxModel> allModels;
-    std::vector<std::vector<VmaxRGBA>> vmaxPalettes; // one palette per model
-    std::vector<std::array<VmaxMaterial, 8>> vmaxMaterials; // one material per model
-    //std::vector<std::array<VmaxMaterial, 8>> allMaterials; // one material per model
-    //std::vector<std::vector<VmaxRGBA>> allPalettes;
 
     essentialsToScene(belScene); // create the basic scene elements in Bella
     
     // Loop over each model defined in scene.json and process the first instance 
     // This will be out canonical models, not instances
-    // todo rename model to objects as per vmax
-    for (const auto& [vmaxContentName, vmaxModelList] : modelVmaxbMap) { 
-        VmaxModel currentVmaxModel(vmaxContentName);
-        const auto& jsonModelInfo = vmaxModelList.front(); // get the first model, others are instances at the scene level
-        std::vector<double> position = jsonModelInfo.position;
-        std::vector<double> rotation = jsonModelInfo.rotation;
-        std::vector<double> scale = jsonModelInfo.scale;
-        std::vector<double> extentCenter = jsonModelInfo.extentCenter;
-
-        // Get this models colors from the paletteN.png 
-        dl::String pngName = vmaxDirName + "/" + jsonModelInfo.paletteFile.c_str();
-        auto materialName = pngName.replace(".png", ".settings.vmaxpsb");
-        vmaxPalettes.push_back(read256x1PaletteFromPNG(pngName.buf())); // gather all models palettes
-        if (vmaxPalettes.empty()) { throw std::runtime_error("Failed to read palette from: png " ); }
-
-        // Read contentsN.vmaxb plist file, lzfse compressed
-        dl::String modelFileName = vmaxDirName + "/" + jsonModelInfo.dataFile.c_str();
-        plist_t plist_model_root = readPlist(modelFileName.buf(), true); // decompress=true
-
-        // There will one or more snapshots in the plist file
-        // Each snapshot is a capture of a 32x32x32 voxel chunk at a point in time
-        // A chunkId is a morton code that uniquely identifies the chunk is a 8x8x8 array within 256x256x256 model volume
-        // The highest index snapshot is the current state of the model
-        // One can traverse the snapshots in reverse to get the history of the model frok inception
-        plist_t plist_snapshots_array = plist_dict_get_item(plist_model_root, "snapshots");
-        uint32_t snapshots_array_size = plist_array_get_size(plist_snapshots_array);
-        #ifdef _DEBUG
-            std::cout << "vmaxContentName: " << vmaxContentName << std::endl;
-            std::cout << "snapshots_array_size: " << snapshots_array_size << std::endl;
-        #endif
-
-        // Create a VmaxModel object
-        for (uint32_t i = 0; i < snapshots_array_size; i++) {
-            plist_t plist_snapshot = plist_array_get_item(plist_snapshots_array, i);
-            plist_t plist_chunk = getNestedPlistNode(plist_snapshot, {"s", "id", "c"});
-            plist_t plist_datastream = getNestedPlistNode(plist_snapshot, {"s", "ds"});
-            uint64_t chunkID;
-            plist_get_uint_val(plist_chunk, &chunkID);
-            VmaxChunkInfo chunkInfo = vmaxChunkInfo(plist_snapshot);
-            #ifdef _DEBUG
-                std::cout << "\nChunkID: " << chunkInfo.id << std::endl;
-                std::cout << "TypeID: " << chunkInfo.type << std::endl;
-                std::cout << "MortonCode: " << chunkInfo.mortoncode << "\n" <<std::endl;
-            #endif
-
-
-            std::vector<VmaxVoxel> xvoxels = vmaxVoxelInfo(plist_datastream, chunkInfo.id, chunkInfo.mortoncode);
-
-            for (const auto& voxel : xvoxels) {
-                currentVmaxModel.addVoxel(voxel.x, voxel.y, voxel.z, voxel.material, voxel.palette ,chunkInfo.id, chunkInfo.mortoncode);
-            }
-        }
-        allModels.push_back(currentVmaxModel);
-
-        // Parse the materials store in paletteN.settings.vmaxpsb    
-        plist_t plist_material = readPlist(materialName.buf(),false); // decompress=false
-        std::array<VmaxMaterial, 8> currentMaterials = getVmaxMaterials(plist_material);
-        vmaxMaterials.push_back(currentMaterials);
+    // Decoding (png, lzfse, plist, voxels) is independent per model so it runs on a worker pool
+    // Unchanged models come from modelCache instead of being decoded again
+    std::vector<std::shared_ptr<const VmaxDecodedModel>> decodedModels(vmaxScene.contents.size());
+    std::string vmaxDir = vmaxDirName.buf();
+    size_t memoryHitsBefore, diskHitsBefore, missesBefore;
+    modelCache.getCounts(memoryHitsBefore, diskHitsBefore, missesBefore);
+    std::vector<uint64_t> modelKeys(vmaxScene.contents.size());
+    // --region: models no object in the region uses are not read, chunks outside it are not decoded
+    std::vector<bool> objectInRegion;
+    std::vector<VmaxDecodeOptions> decodeOptions = regionDecodeOptions(vmaxScene, options, objectInRegion);
+    if (options.region.enabled) {
+        size_t objectsIn = std::count(objectInRegion.begin(), objectInRegion.end(), true);
+        size_t contentsIn = std::count_if(decodeOptions.begin(), decodeOptions.end(), [](const VmaxDecodeOptions& decode) { return decode.decodesAnyChunk(); });
+        std::cout << "In region: " << objectsIn << " of " << objectInRegion.size() << " objects, "
+                  << contentsIn << " of " << decodeOptions.size() << " models" << std::endl;
     }
+    runParallel(decodedModels.size(), options.jobs, [&](size_t contentIndex) {
+        if (!decodeOptions[contentIndex].decodesAnyChunk()) return;
+        const JsonModelInfo& files = vmaxScene.contents[contentIndex].files;
+        decodedModels[contentIndex] = modelCache.decode(vmaxDir, files.dataFile, files, decodeOptions[contentIndex], &modelKeys[contentIndex]);
+        writeModelVxc(options, *decodedModels[contentIndex]);
+    });
+    size_t memoryHits, diskHits, misses;
+    modelCache.getCounts(memoryHits, diskHits, misses);
+    std::cout << "Models decoded: " << misses - missesBefore 
+              << ", cached: " << (memoryHits - memoryHitsBefore) + (diskHits - diskHitsBefore) << std::endl;
+
     // Need to access voxels by material and color groupings
     // Models are canonical models, not instances
     // Vmax objects are instances of models
     // First create canonical models and they are NOT attached to belWorld
-    int modelIndex=0;
-    for (const auto& eachModel : allModels) {
-        dl::bella_sdk::Node belModel = addModelToScene(belScene, belWorld, eachModel, vmaxPalettes[modelIndex], vmaxMaterials[modelIndex]);
-        dl::String lllmodelName = dl::String(eachModel.vmaxbFileName.c_str());
-        dl::String lllcanonicalName = lllmodelName.replace(".vmaxb", "");
-        belCanonicalNodes[lllcanonicalName.buf()] = belModel;
-        std::cout << lllcanonicalName.buf() << std::endl;
-        modelIndex++;
+    // Bella scene graph construction stays on this thread
+    for (size_t contentIndex = 0; contentIndex < decodedModels.size(); contentIndex++) {
+        if (!decodedModels[contentIndex]) continue; // outside --region
+        const VmaxDecodedModel& decoded = *decodedModels[contentIndex];
+        std::vector<dl::bella_sdk::Node>* createdNodes = keepState ? &keepState->modelNodes[decoded.model.vmaxbFileName] : nullptr;
+        std::set<std::string>* usedMaterials = keepState ? &keepState->modelMaterials[decoded.model.vmaxbFileName] : nullptr;
+        belCanonicalNodes[contentIndex] = addModelToScene(belScene, belWorld, decoded.model, decoded.palette, decoded.materials, options, createdNodes, usedMaterials);
+        std::cout << vmaxScene.contents[contentIndex].nodeName << std::endl;
     }
 
     // Second Loop through each vmax object and create an instance of the canonical model
     // This is the instances of the models, we did a pass to create the canonical models earlier
-    for (const auto& [vmaxContentName, vmaxModelList] : modelVmaxbMap) { 
-        VmaxModel currentVmaxModel(vmaxContentName);
-        for(const auto& jsonModelInfo : vmaxModelList) {
-            std::vector<double> position = jsonModelInfo.position;
-            std::vector<double> rotation = jsonModelInfo.rotation;
-            std::vector<double> scale = jsonModelInfo.scale;
-            std::vector<double> extentCenter = jsonModelInfo.extentCenter;
-            auto jsonParentId = jsonModelInfo.parentId;
-            auto belParentId = dl::String(jsonParentId.c_str());
-            dl::String belParentGroupUUID = belParentId.replace("-", "_");
-            belParentGroupUUID = "_" + belParentGroupUUID;
-
-            auto belObjectId = dl::String(jsonModelInfo.id.c_str());
-            belObjectId = belObjectId.replace("-", "_");
-            belObjectId = "_" + belObjectId;
-
-            dl::String getCanonicalName = dl::String(jsonModelInfo.dataFile.c_str());
-            dl::String canonicalName = getCanonicalName.replace(".vmaxb", "");
-            //get bel node from canonical name
-            auto belCanonicalNode = belCanonicalNodes[canonicalName.buf()];
-            auto foofoo = belScene.findNode(canonicalName);
-
-
-            VmaxMatrix4x4 objectMat4 = combineVmaxTransforms(rotation[0], 
-                                                             rotation[1], 
-                                                             rotation[2], 
-                                                             rotation[3],
-                                                             position[0], 
-                                                             position[1], 
-                                                             position[2], 
-                                                             scale[0], 
-                                                             scale[1], 
-                                                             scale[2]);
-
-            auto belNodeObjectInstance = belScene.createNode("xform", belObjectId, belObjectId);
-            belNodeObjectInstance["steps"][0]["xform"] = dl::Mat4({
-                objectMat4.m[0][0], objectMat4.m[0][1], objectMat4.m[0][2], objectMat4.m[0][3],
-                objectMat4.m[1][0], objectMat4.m[1][1], objectMat4.m[1][2], objectMat4.m[1][3],
-                objectMat4.m[2][0], objectMat4.m[2][1], objectMat4.m[2][2], objectMat4.m[2][3],
-                objectMat4.m[3][0], objectMat4.m[3][1], objectMat4.m[3][2], objectMat4.m[3][3]
-                });
-
-            if (jsonParentId == "") {
-                belNodeObjectInstance.parentTo(belScene.world());
-            } else {
-                belNodeObjectInstance.parentTo(belGroupNodes[belParentGroupUUID]);
+    for (size_t objectIndex = 0; objectIndex < vmaxScene.objects.size(); objectIndex++) { 
+        const VmaxSceneObject& object = vmaxScene.objects[objectIndex];
+        if (!objectInRegion[objectIndex] || !decodedModels[object.content]) continue;
+        dl::String belObjectId = object.nodeName.c_str();
+        auto belNodeObjectInstance = belScene.createNode("xform", belObjectId, belObjectId);
+        belNodeObjectInstance["steps"][0]["xform"] = vmaxTransformToBella(object.transform);
+
+        if (object.parent < 0) {
+            belNodeObjectInstance.parentTo(belWorld);
+        } else {
+            belNodeObjectInstance.parentTo(belGroupNodes[object.parent]);
+        }
+        belCanonicalNodes[object.content].parentTo(belNodeObjectInstance);
+    }
+    if (keepState) {
+        keepState->scene = belScene;
+        keepState->modelKeys.clear();
+        for (size_t contentIndex = 0; contentIndex < vmaxScene.contents.size(); contentIndex++) {
+            keepState->modelKeys[vmaxScene.contents[contentIndex].files.dataFile] = modelKeys[contentIndex];
+        }
+        keepState->vmaxScene = std::move(vmaxScene);
+    }
+}
+
+// Bring a scene made by convertVmaxToBella up to date with a re-exported .vmax
+// Diffs scene.json and the content key of every model, then inside one EventScope
+//  - rewrites the xform of groups and objects that moved
+//  - deletes and rebuilds only the canonical models whose .vmaxb, palette or materials changed
+// Adding, removing or re-parenting groups and objects is left to a full conversion
+// @param state - from convertVmaxToBella(keepState), updated in place
+// @return - false when the change needs a full conversion, state is then untouched
+bool updateVmaxBellaScene(VmaxBellaScene& state, const dl::String& vmaxDirName, const ConvertOptions& options)
+{
+    if (options.region.enabled) return false; // a moved object can enter or leave the region, rebuild it all
+    VmaxZipMount zipMount(vmaxDirName.buf());
+    VmaxScene vmaxScene;
+    if (!vmaxScene.parse((vmaxDirName+"/scene.json").buf())) return false;
+    const VmaxScene& was = state.vmaxScene;
+
+    // Same groups, objects, parents and files, anything else is a full conversion
+    // Ids are interned per parse, so they are compared as strings
+    if (vmaxScene.groups.size() != was.groups.size() || vmaxScene.contents.size() != was.contents.size()) return false;
+    for (size_t groupIndex = 0; groupIndex < vmaxScene.groups.size(); groupIndex++) {
+        if (vmaxScene.idOf(vmaxScene.groups[groupIndex].id) != was.idOf(was.groups[groupIndex].id) ||
+            vmaxScene.parentIdOfGroup(groupIndex) != was.parentIdOfGroup(groupIndex)) return false;
+    }
+    for (size_t contentIndex = 0; contentIndex < vmaxScene.contents.size(); contentIndex++) {
+        const VmaxSceneContent& now = vmaxScene.contents[contentIndex];
+        const VmaxSceneContent& before = was.contents[contentIndex];
+        if (now.files.dataFile != before.files.dataFile || now.files.paletteFile != before.files.paletteFile ||
+            now.objects.size() != before.objects.size()) return false;
+        for (size_t i = 0; i < now.objects.size(); i++) {
+            if (vmaxScene.idOf(vmaxScene.objects[now.objects[i]].id) != was.idOf(was.objects[before.objects[i]].id) ||
+                vmaxScene.parentIdOfObject(now.objects[i]) != was.parentIdOfObject(before.objects[i])) return false;
+        }
+    }
+
+    // Which models changed, hashing is all an unchanged model costs
+    std::string vmaxDir = vmaxDirName.buf();
+    std::vector<uint64_t> modelKeys(vmaxScene.contents.size());
+    runParallel(vmaxScene.contents.size(), options.jobs, [&](size_t contentIndex) {
+        const JsonModelInfo& files = vmaxScene.contents[contentIndex].files;
+        modelKeys[contentIndex] = vmaxModelCacheKey(vmaxDir, files.dataFile, files, options.decode);
+    });
+    std::vector<size_t> changedModels;
+    for (size_t contentIndex = 0; contentIndex < vmaxScene.contents.size(); contentIndex++) {
+        uint64_t key = modelKeys[contentIndex];
+        if (key == 0 || key != state.modelKeys[vmaxScene.contents[contentIndex].files.dataFile]) changedModels.push_back(contentIndex);
+    }
+    std::vector<std::shared_ptr<const VmaxDecodedModel>> decodedModels(changedModels.size());
+    runParallel(changedModels.size(), options.jobs, [&](size_t changedIndex) {
+        size_t contentIndex = changedModels[changedIndex];
+        const JsonModelInfo& files = vmaxScene.contents[contentIndex].files;
+        decodedModels[changedIndex] = modelCache.decodeKeyed(modelKeys[contentIndex], vmaxDir, files.dataFile, files, options.decode);
+        writeModelVxc(options, *decodedModels[changedIndex]);
+    });
+
+    dl::bella_sdk::Scene& belScene = state.scene;
+    auto belWorld = belScene.world();
+    size_t movedCount = 0;
+    {
+        dl::bella_sdk::Scene::EventScope es(belScene);
+        for (size_t groupIndex = 0; groupIndex < vmaxScene.groups.size(); groupIndex++) {
+            const VmaxSceneGroup& group = vmaxScene.groups[groupIndex];
+            if (group.transform == was.groups[groupIndex].transform) continue;
+            belScene.findNode(group.nodeName.c_str())["steps"][0]["xform"] = vmaxTransformToBella(group.transform);
+            movedCount++;
+        }
+
+        std::set<std::string> droppedMaterials; // used by a rebuilt model before, maybe by nothing now
+        for (size_t changedIndex = 0; changedIndex < changedModels.size(); changedIndex++) {
+            const VmaxSceneContent& content = vmaxScene.contents[changedModels[changedIndex]];
+            std::vector<dl::bella_sdk::Node>& modelNodes = state.modelNodes[content.files.dataFile];
+            for (dl::bella_sdk::Node& node : modelNodes) {
+                belScene.deleteNode(node);
+            }
+            modelNodes.clear();
+            std::set<std::string>& modelMaterials = state.modelMaterials[content.files.dataFile];
+            droppedMaterials.insert(modelMaterials.begin(), modelMaterials.end());
+            modelMaterials.clear();
+            const VmaxDecodedModel& decoded = *decodedModels[changedIndex];
+            dl::bella_sdk::Node belModel = addModelToScene(belScene, belWorld, decoded.model, decoded.palette, decoded.materials, options, &modelNodes, &modelMaterials);
+            for (uint32_t objectIndex : content.objects) {
+                belModel.parentTo(belScene.findNode(vmaxScene.objects[objectIndex].nodeName.c_str()));
+            }
+        }
+        // Interned materials no model uses any more, a changed palette would otherwise leave them behind
+        for (const auto& [contentName, modelMaterials] : state.modelMaterials) {
+            for (const std::string& materialName : modelMaterials) droppedMaterials.erase(materialName);
+        }
+        for (const std::string& materialName : droppedMaterials) {
+            dl::bella_sdk::Node belMaterial = belScene.findNode(materialName.c_str());
+            if (belMaterial) belScene.deleteNode(belMaterial);
+        }
+
+        for (size_t contentIndex = 0; contentIndex < vmaxScene.contents.size(); contentIndex++) {
+            const VmaxSceneContent& now = vmaxScene.contents[contentIndex];
+            const VmaxSceneContent& before = was.contents[contentIndex];
+            for (size_t i = 0; i < now.objects.size(); i++) {
+                const VmaxSceneObject& object = vmaxScene.objects[now.objects[i]];
+                if (object.transform == was.objects[before.objects[i]].transform) continue;
+                belScene.findNode(object.nodeName.c_str())["steps"][0]["xform"] = vmaxTransformToBella(object.transform);
+                movedCount++;
             }
-            foofoo.parentTo(belNodeObjectInstance);
         }
     }
-    return belScene;
-}
\ No newline at end of file
+    std::cout << "Incremental update: " << changedModels.size() << " of " << vmaxScene.contents.size() 
+              << " models rebuilt, " << movedCount << " xforms moved" << std::endl;
+
+    for (size_t contentIndex = 0; contentIndex < vmaxScene.contents.size(); contentIndex++) {
+        state.modelKeys[vmaxScene.contents[contentIndex].files.dataFile] = modelKeys[contentIndex];
+    }
+    state.vmaxScene = std::move(vmaxScene);
+    return true;
+}
+
+// Inputs of --batch, sorted so runs and manifests are repeatable
+// @param batchSpec - a directory tree searched for .vmax directories and .vmax.zip files,
+//                    a glob like archive/*.vmax (wildcards in the last part only),
+//                    or a list file with one .vmax per line, relative to the list file, # starts a comment
+std::vector<std::string> collectBatchInputs(const std::string& batchSpec) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> inputs;
+    std::error_code ec;
+    fs::path specPath(batchSpec);
+    std::string lastPart = specPath.filename().string();
+    if (lastPart.empty()) lastPart = specPath.parent_path().filename().string(); // trailing slash
+    // The same names the directory walk below picks up
+    bool isVmaxDir = endsWith(lastPart, ".vmax") || endsWith(lastPart, ".vmax.zip");
+
+    if (lastPart.find_first_of("*?") != std::string::npos) {
+        fs::path globDir = specPath.parent_path().empty() ? fs::path(".") : specPath.parent_path();
+        for (const auto& entry : fs::directory_iterator(globDir, fs::directory_options::skip_permission_denied, ec)) {
+            if (globMatch(lastPart, entry.path().filename().string())) {
+                inputs.push_back(entry.path().string());
+            }
+        }
+    } else if (fs::is_directory(specPath, ec) && !isVmaxDir) {
+        fs::recursive_directory_iterator walk(specPath, fs::directory_options::skip_permission_denied, ec);
+        for (auto it = fs::begin(walk); it != fs::end(walk); it.increment(ec)) {
+            if (ec) break;
+            std::string fileName = it->path().filename().string();
+            if (it->is_directory(ec) && endsWith(fileName, ".vmax")) {
+                inputs.push_back(it->path().string());
+                it.disable_recursion_pending(); // a .vmax is a leaf
+            } else if (it->is_regular_file(ec) && endsWith(fileName, ".vmax.zip")) {
+                inputs.push_back(it->path().string());
+            }
+        }
+    } else if (isVmaxDir) {
+        inputs.push_back(batchSpec);
+    } else {
+        std::ifstream listFile(batchSpec);
+        if (!listFile) throw std::runtime_error("Cannot open batch list: " + batchSpec);
+        std::string line;
+        while (std::getline(listFile, line)) {
+            line.erase(0, line.find_first_not_of(" \t"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (line.empty() || line[0] == '#') continue;
+            fs::path listed(line);
+            inputs.push_back(listed.is_absolute() ? line : (specPath.parent_path() / listed).string());
+        }
+    }
+    std::sort(inputs.begin(), inputs.end());
+    return inputs;
+}
+
+// Where runBatch writes the .bsz of every input
+// With an outputDir each input keeps its path relative to the batch root, so a/scene.vmax and
+// b/scene.vmax do not both become outputDir/scene.bsz. Inputs outside the root (list files can
+// point anywhere) keep their file name, a name already taken gets a _2, _3 .. suffix
+std::vector<std::string> batchOutputPaths(const std::string& batchSpec, const std::vector<std::string>& inputs, const std::string& outputDir) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> outputs;
+    std::error_code ec;
+    fs::path specPath(batchSpec);
+    fs::path root = fs::is_directory(specPath, ec) && !endsWith(specPath.filename().string(), ".vmax") ? specPath : specPath.parent_path();
+    std::set<std::string> taken;
+    for (const std::string& vmaxPath : inputs) {
+        if (outputDir.empty()) {
+            outputs.push_back(bszPathForVmax(vmaxPath));
+            continue;
+        }
+        fs::path relative = fs::path(vmaxPath).lexically_relative(root);
+        if (relative.empty() || *relative.begin() == "..") relative = fs::path(vmaxPath).filename();
+        std::string bszPath = bszPathForVmax((fs::path(outputDir) / relative).string());
+        std::string stem = bszPath.substr(0, bszPath.size() - 4);
+        for (int suffix = 2; taken.count(bszPath); suffix++) {
+            bszPath = stem + "_" + std::to_string(suffix) + ".bsz";
+        }
+        taken.insert(bszPath);
+        outputs.push_back(bszPath);
+    }
+    return outputs;
+}
+
+// Convert many .vmax in one process, a failed input is written to the manifest and the run moves on
+// Each worker keeps one scene, it is cleared and gets the node definitions again between inputs
+// @param outputDir - empty writes each .bsz next to its .vmax, see batchOutputPaths()
+// @param manifestName - json lines, one per input as it finishes
+// @return 0 if every input converted, 1 otherwise
+int runBatch(const std::string& batchSpec, const std::string& outputDir, const std::string& manifestName, unsigned workers) {
+    std::vector<std::string> inputs;
+    try {
+        inputs = collectBatchInputs(batchSpec);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (inputs.empty()) {
+        std::cout << "No .vmax found in " << batchSpec << std::endl;
+        return 1;
+    }
+    std::ofstream manifest(manifestName);
+    if (!manifest) {
+        std::cerr << "Cannot write manifest: " << manifestName << std::endl;
+        return 1;
+    }
+    std::vector<std::string> outputs = batchOutputPaths(batchSpec, inputs, outputDir);
+    workers = static_cast<unsigned>(std::min<size_t>(std::max(1u, workers), inputs.size()));
+
+    // Split the cores between the workers unless --jobs asked for something else
+    ConvertOptions options = convertOptions;
+    if (options.jobs == 0) {
+        options.jobs = std::max(1u, std::thread::hardware_concurrency() / workers);
+    }
+    // Every input is different, keeping decoded models around would only grow memory
+    // the disk cache of --cachedir still applies
+    modelCache.setMaxEntries(0);
+
+    std::cout << "Batch converting " << inputs.size() << " .vmax with " << workers << " workers" << std::endl;
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failed(0);
+    std::mutex manifestMutex;
+    auto batchStart = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        dl::bella_sdk::Scene belScene;
+        belScene.loadDefs();
+        for (size_t i = next++; i < inputs.size(); i = next++) {
+            const std::string& vmaxPath = inputs[i];
+            const std::string& bszPath = outputs[i];
+            auto start = std::chrono::steady_clock::now();
+            std::string error;
+            try {
+                belScene.clear(); // drops the definitions too, like the --preview rebuild
+                belScene.loadDefs();
+                if (!outputDir.empty()) std::filesystem::create_directories(std::filesystem::path(bszPath).parent_path());
+                buildVmaxScene(belScene, dl::String(vmaxPath.c_str()), convertOptionsFor(bszPath, options));
+                if (!writeBellaScene(belScene, bszPath)) error = "Failed to write " + bszPath;
+            } catch (const std::exception& e) {
+                error = e.what();
+            } catch (...) {
+                error = "unknown error";
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (!error.empty()) failed++;
+
+            json entry = {{"input", vmaxPath}, {"output", bszPath}, {"status", error.empty() ? "ok" : "failed"}, {"ms", ms}};
+            if (!error.empty()) entry["error"] = error;
+            std::lock_guard<std::mutex> lock(manifestMutex);
+            manifest << entry.dump() << std::endl; // flushed per line so a killed run keeps what it did
+            std::cout << "[" << i + 1 << "/" << inputs.size() << "] " << (error.empty() ? "ok     " : "FAILED ")
+                      << vmaxPath << (error.empty() ? "" : ": " + error) << std::endl;
+        }
+    };
+    std::vector<std::thread> workerThreads;
+    for (unsigned t = 1; t < workers; t++) {
+        workerThreads.emplace_back(worker);
+    }
+    worker();
+    for (auto& workerThread : workerThreads) {
+        workerThread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+    std::cout << "Batch done: " << inputs.size() - failed << " converted, " << failed << " failed in "
+              << seconds << " s, manifest " << manifestName << std::endl;
+    reportStats();
+    return failed ? 1 : 0;
+}